@@ -104,8 +104,8 @@ void Game::init() {
             Storage::retrieve();
     reset();
 
-    // Make account XP multiplier available to JS (used by Title Screen leaderboard calc)
-    EM_ASM({ try { Module.ACCOUNT_XP_MULT = $0|0; } catch(e) {} }, ACCOUNT_XP_MULTIPLIER);
+    // Make the account XP table available to JS (used by Title Screen leaderboard calc), so it matches the server
+    EM_ASM({ Module.ACCOUNT_LEVEL_XP = Array.from(HEAPU32.subarray($0 >> 2, ($0 >> 2) + $1)); }, ACCOUNT_LEVEL_XP, MAX_LEVEL + 2);
 
         // Prime login state immediately
     update_logged_in_as();
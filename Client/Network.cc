@@ -6,14 +6,20 @@
 
 #include <Shared/Binary.hh>
 #include <Shared/Config.hh>
+#include <Shared/StaticData.hh>
+
+#include <algorithm>
 
 using namespace Game;
 
+static uint32_t update_count = 0;
+
 void Game::on_message(uint8_t *ptr, uint32_t len) {
     Reader reader(ptr);
         switch(reader.read<uint8_t>()) {
         case Clientbound::kClientUpdate: {
             simulation_ready = 1;
+            ++update_count;
             camera_id = reader.read<EntityID>();
             EntityID curr_id = reader.read<EntityID>();
                         while(!(curr_id == NULL_ENTITY)) {
@@ -32,6 +38,10 @@ void Game::on_message(uint8_t *ptr, uint32_t len) {
                 assert(simulation.ent_exists(curr_id));
                 Entity &ent = simulation.get_ent(curr_id);
                 ent.read(&reader, BitMath::at(create, 0));
+                //the server holds back updates for far and idle entities, so track how often this one comes
+                if (!BitMath::at(create, 0))
+                    ent.update_interval = std::clamp<uint32_t>(update_count - ent.last_update, 1, TPS);
+                ent.last_update = update_count;
                 if (BitMath::at(create, 1)) ent.pending_delete = 1;
                 curr_id = reader.read<EntityID>();
             }
@@ -100,6 +110,17 @@ void Game::on_message(uint8_t *ptr, uint32_t len) {
             Debug::ping_times.push_back(rtt);
             break;
         }
+        case Clientbound::kBatch: {
+            uint8_t *end = ptr + len;
+            while (reader.at < end) {
+                uint32_t size = reader.read<uint32_t>();
+                uint8_t *message = const_cast<uint8_t *>(reader.at);
+                if (message + size > end) break;
+                Game::on_message(message, size);
+                reader.at += size;
+            }
+            break;
+        }
         default:
             break;
     }
@@ -11,9 +11,11 @@ void Entity::tick_lerp(float amt) {
     if (has_component(kPhysics)) {
         float prev_x = x;
         float prev_y = y;
+        //entities updated every few ticks ease over the whole gap instead of jumping then waiting
+        float const move_amt = update_interval > 1 ? 1 - powf(1 - amt, 1.0f / update_interval) : amt;
         if (!pending_delete) {
-            x.step(amt);
-            y.step(amt);
+            x.step(move_amt);
+            y.step(move_amt);
         }
         if (has_component(kDrop) || has_component(kWeb)) {
             if (lifetime < TPS)
@@ -24,7 +26,7 @@ void Entity::tick_lerp(float amt) {
             animation += (1 + 0.75 * vel.magnitude()) * 0.075;
         }
         radius.step(amt);
-        angle.step_angle(amt);
+        angle.step_angle(move_amt);
         if (pending_delete)
             deletion_animation = fclamp(deletion_animation + Ui::dt / 150, 0, 1);
     }
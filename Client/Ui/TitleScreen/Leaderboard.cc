@@ -35,7 +35,9 @@ static constexpr float ACCOUNT_LB_WIDTH = 200.0f;
 extern "C" {
     EM_JS(void, update_account_leaderboard, (), {
         if (typeof fetch !== 'function') return;
-        function calcNeed(level){ level = level|0; var M = (Module && Module.ACCOUNT_XP_MULT)|0; if (!M) M = 100; return (((Math.pow(1.06, level - 1) * level) + 3) * M) | 0; }
+        // Both read the account XP table Game::init copies from the C++ side
+        function calcNeed(level){ const t = Module.ACCOUNT_LEVEL_XP; level = Math.min(Math.max(level|0, 1), t.length - 2); return t[level + 1] - t[level]; }
+        function calcLevel(xp){ const t = Module.ACCOUNT_LEVEL_XP; let lo = 1, hi = t.length - 2; while (lo < hi) { const mid = (lo + hi + 1) >> 1; if (t[mid] <= xp) lo = mid; else hi = mid - 1; } return lo; }
         if (!Module._acctLbTimer) {
             const log = function(){};
             Module._acctLbPolls = 0;
@@ -75,7 +77,7 @@ extern "C" {
                         // Fallback if account_level missing
                         if (!me['account_level']) {
                             // derive level from XP approximately
-                            selfLevel = 1; let left = selfXp|0; while (selfLevel < 99) { const need = calcNeed(selfLevel); if (left < need) break; left -= need; selfLevel++; }
+                            selfLevel = calcLevel(selfXp|0);
                         }
                         const selfXpNeeded = ((me['xpNeeded']|0) || calcNeed(selfLevel));
                         // Fetch true global rank for this account from same source as list
@@ -112,9 +114,6 @@ extern "C" {
             };
             Module._acctLbFetch = fetchIt;
             Module._acctLbTimer = setInterval(fetchIt, 3000);
-            try { if (typeof ENV !== 'undefined' && ENV && ENV.ACCOUNT_XP_MULT) Module.ACCOUNT_XP_MULT = (ENV.ACCOUNT_XP_MULT|0); } catch(e) {}
-            try { if (!Module.ACCOUNT_XP_MULT && typeof process !== 'undefined' && process && process.env && process.env.ACCOUNT_XP_MULT) Module.ACCOUNT_XP_MULT = (parseInt(process.env.ACCOUNT_XP_MULT,10)||100); } catch(e) {}
-            if (!Module.ACCOUNT_XP_MULT) Module.ACCOUNT_XP_MULT = 100;
             fetchIt();
         }
     });
@@ -176,9 +175,8 @@ namespace Ui {
                     int lvl = get_account_lb_level(idx);
                     int xp = get_account_lb_xp(idx);
                     if (lvl < 1) lvl = 1;
-                    double total = (double)xp;
-                    for (int l = 1; l < lvl; ++l) total += (double)score_to_pass_level(l) * (double)ACCOUNT_XP_MULTIPLIER;
-                    return total;
+                    if (lvl > (int)MAX_LEVEL) lvl = MAX_LEVEL;
+                    return (double)ACCOUNT_LEVEL_XP[lvl] + (double)xp;
                 };
                 int showN = std::min(count, (int)ACCOUNT_LB_SIZE);
                 if (pos >= (uint8_t)showN) return;
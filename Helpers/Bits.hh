@@ -5,6 +5,7 @@
 namespace BitMath {
     constexpr uint32_t count(uint32_t v) {return 32 - __builtin_clz(v - 1); };
     constexpr uint32_t fill(uint32_t v) { return (1 << v) - 1; }; 
+    constexpr uint32_t lowest(uint64_t v) { return __builtin_ctzll(v); };
     template<typename T>
     constexpr T at(T const &val, uint32_t bit) { return (val >> bit) & 1; };
     template<typename T>
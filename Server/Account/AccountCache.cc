@@ -0,0 +1,113 @@
+#include <Server/Account/AccountCache.hh>
+
+#include <Server/Account/AccountLevel.hh>
+#include <Server/AuthDB.hh>
+
+#include <Helpers/Bits.hh>
+
+#include <unordered_map>
+#include <vector>
+
+namespace AccountCache {
+    static std::unordered_map<std::string, Account> g_accounts;
+
+    static void set_level(Account &acc) {
+        uint32_t level = 1, level_xp = 0;
+        AccountLevel::level_from_total(acc.xp, level, level_xp);
+        if (level == acc.level && level_xp == acc.level_xp) return;
+        acc.level = level;
+        acc.level_xp = level_xp;
+        acc.dirty |= kLevel;
+    }
+
+    static void write_back(std::string const &account_id, Account &acc) {
+        if (!acc.pending) return;
+        if (acc.pending_xp > 0) AuthDB::add_account_xp(account_id, (int)acc.pending_xp);
+        for (uint32_t i = 0; i < MobID::kNumMobs; ++i)
+            if (acc.pending_kills[i] > 0) AuthDB::record_mob_kill(account_id, (int)i, (int)acc.pending_kills[i]);
+        for (uint32_t i = 0; i < PetalID::kNumPetals; ++i)
+            if (BitMath::at_arr(acc.pending_petals.data(), i)) AuthDB::record_petal_obtained(account_id, (int)i);
+        acc.pending_xp = 0;
+        acc.pending_kills.fill(0);
+        acc.pending_petals.fill(0);
+        acc.pending = 0;
+    }
+
+    Account *load(std::string const &account_id) {
+        auto [it, inserted] = g_accounts.try_emplace(account_id);
+        Account &acc = it->second;
+        ++acc.refs;
+        if (!inserted) return &acc;
+        int xp = 0;
+        AuthDB::get_account_xp(account_id, xp);
+        acc.xp = (uint32_t)xp;
+        AccountLevel::level_from_total(acc.xp, acc.level, acc.level_xp);
+        std::vector<int> ids;
+        AuthDB::get_mob_ids(account_id, ids);
+        for (int id : ids)
+            if (id >= 0 && id < MobID::kNumMobs) BitMath::set_arr(acc.mob_gallery.data(), id);
+        AuthDB::get_petal_ids(account_id, ids);
+        for (int id : ids)
+            if (id >= 0 && id < PetalID::kNumPetals) BitMath::set_arr(acc.petal_gallery.data(), id);
+        return &acc;
+    }
+
+    void release(std::string const &account_id) {
+        auto it = g_accounts.find(account_id);
+        if (it == g_accounts.end()) return;
+        if (--it->second.refs > 0) return;
+        write_back(account_id, it->second);
+        g_accounts.erase(it);
+    }
+
+    Account *get(std::string const &account_id) {
+        auto it = g_accounts.find(account_id);
+        return it == g_accounts.end() ? nullptr : &it->second;
+    }
+
+    void add_xp(std::string const &account_id, uint32_t xp) {
+        Account *acc = get(account_id);
+        if (acc == nullptr) {
+            AuthDB::add_account_xp(account_id, (int)xp);
+            return;
+        }
+        acc->xp += xp;
+        acc->pending_xp += xp;
+        acc->pending = 1;
+        set_level(*acc);
+    }
+
+    void record_mob_kill(std::string const &account_id, MobID::T mob_id) {
+        Account *acc = get(account_id);
+        if (acc == nullptr) {
+            AuthDB::record_mob_kill(account_id, (int)mob_id);
+            return;
+        }
+        ++acc->pending_kills[mob_id];
+        acc->pending = 1;
+        if (BitMath::at_arr(acc->mob_gallery.data(), mob_id)) return;
+        BitMath::set_arr(acc->mob_gallery.data(), mob_id);
+        acc->dirty |= kMobGallery;
+    }
+
+    void record_petal_obtained(std::string const &account_id, PetalID::T petal_id) {
+        Account *acc = get(account_id);
+        if (acc == nullptr) {
+            AuthDB::record_petal_obtained(account_id, (int)petal_id);
+            return;
+        }
+        //the gallery only keeps whether it was ever obtained, so repeats never reach storage
+        if (BitMath::at_arr(acc->petal_gallery.data(), petal_id)) return;
+        BitMath::set_arr(acc->petal_gallery.data(), petal_id);
+        BitMath::set_arr(acc->pending_petals.data(), petal_id);
+        acc->pending = 1;
+        acc->dirty |= kPetalGallery;
+    }
+
+    void flush() {
+        for (auto &[account_id, acc] : g_accounts) {
+            write_back(account_id, acc);
+            acc.dirty = 0;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Shared/StaticData.hh>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+//native server's copy of each online account, loaded from AuthDB when a client joins
+//and authoritative until its last client leaves, so galleries and levels never re-read storage
+//only touched from the game thread
+namespace AccountCache {
+    enum Dirty : uint8_t {
+        kMobGallery = 1 << 0,
+        kPetalGallery = 1 << 1,
+        kLevel = 1 << 2
+    };
+
+    struct Account {
+        uint32_t xp = 0;
+        uint32_t level = 1;
+        //xp towards the next level
+        uint32_t level_xp = 0;
+        //same layout as the kMobGallery and kPetalGallery messages
+        std::array<uint8_t, div_round_up(MobID::kNumMobs, 8)> mob_gallery{};
+        std::array<uint8_t, div_round_up(PetalID::kNumPetals, 8)> petal_gallery{};
+        //what changed since clients were last sent it, cleared by flush
+        uint8_t dirty = 0;
+        //changes not yet handed to AuthDB
+        uint32_t pending_xp = 0;
+        std::array<uint32_t, MobID::kNumMobs> pending_kills{};
+        std::array<uint8_t, div_round_up(PetalID::kNumPetals, 8)> pending_petals{};
+        uint8_t pending = 0;
+        //clients online with this account
+        uint32_t refs = 0;
+    };
+
+    //loads the account, or adds a reference if it's already online
+    Account *load(std::string const &account_id);
+    //writes back what's pending and drops the account once no client holds it
+    void release(std::string const &account_id);
+    //nullptr unless a client with this account is online
+    Account *get(std::string const &account_id);
+
+    //these fall through to AuthDB for accounts that aren't online
+    void add_xp(std::string const &account_id, uint32_t xp);
+    void record_mob_kill(std::string const &account_id, MobID::T mob_id);
+    void record_petal_obtained(std::string const &account_id, PetalID::T petal_id);
+
+    //hands every pending change to AuthDB and clears the dirty flags, once a tick after clients are sent
+    void flush();
+}
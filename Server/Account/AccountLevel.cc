@@ -1,62 +1,161 @@
 #include <Server/Account/AccountLevel.hh>
 #ifndef WASM_SERVER
+#include <Server/Account/AccountCache.hh>
 #include <Server/AuthDB.hh>
 #else
 #include <Server/Account/WasmAccountStore.hh>
 #endif
 #include <Shared/StaticData.hh>
 
+#include <unordered_map>
+
 namespace AccountLevel {
+    //total xp of offline accounts, so levels and the top account don't hit storage every tick
+    //online accounts are read from AccountCache instead; only touched from the game thread
+    static std::unordered_map<std::string, uint32_t> g_total_xp;
+    //dropped wholesale once it holds this many, entries are cheap to load again
+    static size_t const TOTAL_XP_CAP = 4096;
+    static std::string g_top_account;
+    static uint32_t g_top_xp = 0;
+    static uint8_t g_top_loaded = 0;
+
     static uint32_t account_level_score_to_pass(uint32_t level) {
         if (level >= MAX_LEVEL) return 0xffffffffu; // effectively infinite
-        // Use centralized multiplier from StaticData
-        uint32_t base = score_to_pass_level(level);
-        return base * ACCOUNT_XP_MULTIPLIER;
+        return ACCOUNT_LEVEL_XP[level + 1] - ACCOUNT_LEVEL_XP[level];
     }
     
     uint32_t get_xp_needed_for_next(uint32_t level) {
         return account_level_score_to_pass(level);
     }
 
+    void level_from_total(uint32_t total_xp, uint32_t &level_out, uint32_t &xp_out) {
+        level_out = account_xp_to_level(total_xp);
+        xp_out = total_xp - ACCOUNT_LEVEL_XP[level_out];
+    }
+
 #ifndef WASM_SERVER
-    bool add_xp(const std::string &account_id, uint32_t xp) {
-        return AuthDB::add_account_xp(account_id, (int)xp);
+    static bool online_total(const std::string &account_id, uint32_t &total_out) {
+        AccountCache::Account const *acc = AccountCache::get(account_id);
+        if (acc == nullptr) return false;
+        total_out = acc->xp;
+        return true;
     }
 
-    bool get_level_and_xp(const std::string &account_id, uint32_t &level_out, uint32_t &xp_out) {
+    static bool load_total(const std::string &account_id, uint32_t &total_out) {
         int total_xp = 0;
         if (!AuthDB::get_account_xp(account_id, total_xp)) return false;
-        uint32_t level = 1;
-        int remaining = total_xp;
-        while (level < MAX_LEVEL) {
-            uint32_t need = account_level_score_to_pass(level);
-            if ((uint32_t)remaining < need) break;
-            remaining -= need;
-            ++level;
+        total_out = (uint32_t)total_xp;
+        return true;
+    }
+
+    static void load_top() {
+        g_top_account.clear();
+        g_top_xp = 0;
+        if (AuthDB::get_top_account_by_xp(g_top_account) && !online_total(g_top_account, g_top_xp))
+            load_total(g_top_account, g_top_xp);
+        g_top_loaded = 1;
+    }
+
+    //xp only goes up, so the top account changes only when someone passes it
+    static void update_top(const std::string &account_id, uint32_t total) {
+        if (!g_top_loaded) return;
+        if (account_id == g_top_account) g_top_xp = total;
+        else if (total > g_top_xp) {
+            g_top_account = account_id;
+            g_top_xp = total;
         }
-        level_out = level;
-        xp_out = (uint32_t)remaining;
+    }
+
+    static bool store_xp(const std::string &account_id, uint32_t xp) {
+        AccountCache::add_xp(account_id, xp);
         return true;
     }
 #else
-    bool add_xp(const std::string &account_id, uint32_t xp) {
+    //the wasm server has no AccountCache, every account goes through g_total_xp
+    static bool online_total(const std::string &, uint32_t &) {
+        return false;
+    }
+
+    static bool load_total(const std::string &account_id, uint32_t &total_out) {
+        WasmAccountStore::get_xp(account_id, total_out);
+        return true;
+    }
+
+    static void load_top() {
+        WasmAccountStore::get_top_account(g_top_account);
+        g_top_loaded = 1;
+    }
+
+    //the node host owns the authoritative top account and may include offline accounts
+    //whose xp we don't have, so ask again instead of comparing
+    static void update_top(const std::string &, uint32_t) {
+        g_top_loaded = 0;
+    }
+
+    static bool store_xp(const std::string &account_id, uint32_t xp) {
         return WasmAccountStore::add_xp(account_id, xp);
     }
+#endif
 
-    bool get_level_and_xp(const std::string &account_id, uint32_t &level_out, uint32_t &xp_out) {
-        uint32_t total_xp = 0;
-        WasmAccountStore::get_xp(account_id, total_xp);
-        uint32_t level = 1;
-        uint32_t remaining = total_xp;
-        while (level < MAX_LEVEL) {
-            uint32_t need = account_level_score_to_pass(level);
-            if (remaining < need) break;
-            remaining -= need;
-            ++level;
+    static bool get_total(const std::string &account_id, uint32_t &total_out) {
+        if (online_total(account_id, total_out)) return true;
+        auto it = g_total_xp.find(account_id);
+        if (it != g_total_xp.end()) {
+            total_out = it->second;
+            return true;
         }
-        level_out = level;
-        xp_out = remaining;
+        if (!load_total(account_id, total_out)) return false;
+        if (g_total_xp.size() >= TOTAL_XP_CAP) g_total_xp.clear();
+        g_total_xp.emplace(account_id, total_out);
         return true;
     }
+
+    bool add_xp(const std::string &account_id, uint32_t xp) {
+        if (!store_xp(account_id, xp)) return false;
+        uint32_t total = 0;
+        if (online_total(account_id, total)) {
+            //an entry from before the account came online would go stale
+            g_total_xp.erase(account_id);
+            update_top(account_id, total);
+            return true;
+        }
+        auto it = g_total_xp.find(account_id);
+        if (it != g_total_xp.end()) {
+            it->second += xp;
+            update_top(account_id, it->second);
+        } else if (get_total(account_id, total)) update_top(account_id, total);
+        return true;
+    }
+
+    bool get_level_and_xp(const std::string &account_id, uint32_t &level_out, uint32_t &xp_out) {
+#ifndef WASM_SERVER
+        //online accounts keep their level up to date as xp comes in
+        if (AccountCache::Account const *acc = AccountCache::get(account_id)) {
+            level_out = acc->level;
+            xp_out = acc->level_xp;
+            return true;
+        }
 #endif
+        uint32_t total_xp = 0;
+        if (!get_total(account_id, total_xp)) return false;
+        level_from_total(total_xp, level_out, xp_out);
+        return true;
+    }
+
+    uint32_t get_level(const std::string &account_id) {
+        uint32_t level = 1, xp = 0;
+        get_level_and_xp(account_id, level, xp);
+        return level;
+    }
+
+    std::string const &get_top_account() {
+        if (!g_top_loaded) load_top();
+        return g_top_account;
+    }
+
+    void on_xp_changed(const std::string &account_id) {
+        g_total_xp.erase(account_id);
+        uint32_t total = 0;
+        if (get_total(account_id, total)) update_top(account_id, total);
+    }
 }
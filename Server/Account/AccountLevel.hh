@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 namespace AccountLevel {
@@ -6,6 +7,14 @@ namespace AccountLevel {
     bool add_xp(const std::string &account_id, uint32_t xp);
     // Get current level (1..99) and xp towards next level. Returns true on success.
     bool get_level_and_xp(const std::string &account_id, uint32_t &level_out, uint32_t &xp_out);
+    // Current level only, as shown over a player's flower
+    uint32_t get_level(const std::string &account_id);
     // Get XP needed to reach next level from a given level
     uint32_t get_xp_needed_for_next(uint32_t level);
+    // Level (1..99) and xp towards the next level for a total amount of XP
+    void level_from_total(uint32_t total_xp, uint32_t &level_out, uint32_t &xp_out);
+    // Account with the most XP (empty if none). Only reads storage again after XP changed.
+    std::string const &get_top_account();
+    // Drops the cached XP for an account whose XP was changed from outside add_xp
+    void on_xp_changed(const std::string &account_id);
 }
@@ -1,40 +1,78 @@
 #include <Server/Account/AccountLink.hh>
 
+#include <array>
+#include <deque>
 #include <unordered_map>
-#include <mutex>
 
 namespace {
-    std::unordered_map<uint32_t, std::string> g_entity_to_account;
-    std::mutex g_mu;
+    uint32_t const BOT_HANDLE = 1u << 31;
+
+    //account ids are interned once, so links are a plain index; deque keeps references stable
+    //handle 0 is the empty account
+    std::deque<std::string> g_accounts(1);
+    std::unordered_map<std::string, uint32_t> g_handles;
+
+    struct Link {
+        EntityID::hash_type hash = 0;
+        uint32_t handle = 0;
+    };
+    std::array<Link, ENTITY_CAP> g_links;
+
+    uint32_t intern(const std::string &account_id) {
+        if (account_id.empty()) return 0;
+        auto [it, inserted] = g_handles.try_emplace(account_id, g_accounts.size());
+        if (inserted) g_accounts.push_back(account_id);
+        return it->second;
+    }
+
+    void link(const EntityID &entity_id, uint32_t handle) {
+        if (entity_id.id >= ENTITY_CAP) return;
+        g_links[entity_id.id] = { entity_id.hash, handle };
+    }
+
+    void unlink(const EntityID &entity_id) {
+        if (entity_id.id >= ENTITY_CAP) return;
+        Link &l = g_links[entity_id.id];
+        if (l.hash == entity_id.hash) l.handle = 0;
+    }
+
+    uint32_t handle_for(const EntityID &entity_id) {
+        if (entity_id.id >= ENTITY_CAP) return 0;
+        Link const &l = g_links[entity_id.id];
+        return l.hash == entity_id.hash ? l.handle : 0;
+    }
 }
 
 namespace AccountLink {
 
 void map_camera(const EntityID &camera_id, const std::string &account_id) {
-    std::lock_guard<std::mutex> lk(g_mu);
-    g_entity_to_account[camera_id.id] = account_id;
+    link(camera_id, intern(account_id));
 }
 
 void unmap_camera(const EntityID &camera_id) {
-    std::lock_guard<std::mutex> lk(g_mu);
-    g_entity_to_account.erase(camera_id.id);
+    unlink(camera_id);
 }
 
 void map_player(const EntityID &player_id, const std::string &account_id) {
-    std::lock_guard<std::mutex> lk(g_mu);
-    g_entity_to_account[player_id.id] = account_id;
+    link(player_id, intern(account_id));
 }
 
 void unmap_player(const EntityID &player_id) {
-    std::lock_guard<std::mutex> lk(g_mu);
-    g_entity_to_account.erase(player_id.id);
+    unlink(player_id);
+}
+
+void map_bot(const EntityID &entity_id) {
+    link(entity_id, BOT_HANDLE);
+}
+
+void unmap(const EntityID &entity_id) {
+    unlink(entity_id);
 }
 
-std::string get_account_for_entity(const EntityID &entity_id) {
-    std::lock_guard<std::mutex> lk(g_mu);
-    auto it = g_entity_to_account.find(entity_id.id);
-    if (it != g_entity_to_account.end()) return it->second;
-    return std::string();
+std::string const &get_account_for_entity(const EntityID &entity_id) {
+    uint32_t const handle = handle_for(entity_id);
+    if (handle & BOT_HANDLE) return g_accounts[0];
+    return g_accounts[handle];
 }
 
 } // namespace AccountLink
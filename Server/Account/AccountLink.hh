@@ -3,6 +3,8 @@
 #include <Shared/EntityDef.hh>
 #include <string>
 
+//which account each camera and flower belongs to
+//only touched from the game thread, so lookups take no lock
 namespace AccountLink {
     void map_camera(const EntityID &camera_id, const std::string &account_id);
     void unmap_camera(const EntityID &camera_id);
@@ -10,5 +12,12 @@ namespace AccountLink {
     void map_player(const EntityID &player_id, const std::string &account_id);
     void unmap_player(const EntityID &player_id);
 
-    std::string get_account_for_entity(const EntityID &entity_id);
+    //bots are linked without an account, so they never reach account storage
+    void map_bot(const EntityID &entity_id);
+
+    //drops whatever link the entity has, once it's deleted and its id may be reused
+    void unmap(const EntityID &entity_id);
+
+    //empty for bots, guests, and entities that were deleted since they were linked
+    std::string const &get_account_for_entity(const EntityID &entity_id);
 }
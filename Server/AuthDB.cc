@@ -8,16 +8,117 @@
 #include <cstdlib>
 #include <vector>
 #include <filesystem>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
 
 namespace {
-    sqlite3 *g_db = nullptr;
+    //a connection and the statements prepared on it, which are reset and rebound instead of
+    //prepared again on every call; only one thread uses a connection at a time
+    struct Connection {
+        sqlite3 *db = nullptr;
+        //keyed by the query's string literal
+        std::unordered_map<const char *, sqlite3_stmt *> statements;
+    };
+
+    //cached statement for the scope it's used in; reset on the way out so it can't hold a read open
+    class Statement {
+        sqlite3_stmt *stmt = nullptr;
+    public:
+        Statement(Connection &conn, const char *sql) {
+            auto it = conn.statements.find(sql);
+            if (it != conn.statements.end()) stmt = it->second;
+            else if (sqlite3_prepare_v2(conn.db, sql, -1, &stmt, nullptr) == SQLITE_OK) conn.statements.emplace(sql, stmt);
+            else stmt = nullptr;
+        }
+        ~Statement() {
+            if (stmt == nullptr) return;
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+        Statement(Statement const &) = delete;
+        Statement &operator=(Statement const &) = delete;
+        operator sqlite3_stmt *() const { return stmt; }
+    };
+
+    //schema, account creation and sessions
+    Connection g_main;
     std::string g_db_path;
+
+    //read-only connections for lookups, handed to whichever thread asks; under WAL they read
+    //while the writer commits, so session checks during the handshake don't wait on game writes
+    constexpr uint32_t READ_POOL_SIZE = 4;
+    std::mutex g_pool_mu;
+    std::condition_variable g_pool_cv;
+    std::vector<std::unique_ptr<Connection>> g_readers;
+    std::vector<Connection *> g_idle_readers;
+
+    //false if the pool was never opened, instead of waiting for a reader that won't come
+    class ReadConnection {
+        Connection *conn = nullptr;
+    public:
+        ReadConnection() {
+            std::unique_lock<std::mutex> lk(g_pool_mu);
+            if (g_readers.empty()) return;
+            g_pool_cv.wait(lk, [] { return !g_idle_readers.empty(); });
+            conn = g_idle_readers.back();
+            g_idle_readers.pop_back();
+        }
+        ~ReadConnection() {
+            if (conn == nullptr) return;
+            {
+                std::lock_guard<std::mutex> lk(g_pool_mu);
+                g_idle_readers.push_back(conn);
+            }
+            g_pool_cv.notify_one();
+        }
+        ReadConnection(ReadConnection const &) = delete;
+        ReadConnection &operator=(ReadConnection const &) = delete;
+        Connection &operator*() const { return *conn; }
+        explicit operator bool() const { return conn != nullptr; }
+    };
+
+    //gameplay writes not committed yet, coalesced per account as they are queued:
+    //xp deltas add up, kills add up per mob, petals are a set
+    //so the queue is bounded by accounts * (mobs + petals), however fast events come in
+    struct PendingWrites {
+        int xp = 0;
+        std::map<int, int> mob_kills;
+        std::set<int> petals;
+    };
+    typedef std::unordered_map<std::string, PendingWrites> PendingMap;
+
+    //how long the writer lets writes pile up before committing them in one transaction
+    constexpr std::chrono::milliseconds WRITE_BEHIND_INTERVAL(500);
+
+    //guards everything below except g_writer_conn, which only the writer thread touches
+    std::mutex g_write_mu;
+    std::condition_variable g_write_cv;
+    PendingMap g_queued;
+    //batch the writer is committing; readers still see it until it lands
+    PendingMap g_committing;
+    //each batch stores its sequence number in meta.write_seq in the same transaction,
+    //so a reader can tell whether its snapshot already includes g_committing
+    uint64_t g_committing_seq = 0;
+    uint64_t g_next_seq = 1;
+    bool g_writer_stop = false;
+    std::thread g_writer;
+    Connection g_writer_conn;
 }
 
 namespace AuthDB {
 
+static bool open_readers();
+static bool start_writer();
+static void close_all();
+
 bool init(const std::string &db_path) {
-    if (g_db) return true;
+    if (g_main.db) return true;
     if (!db_path.empty()) {
         g_db_path = db_path;
     } else {
@@ -41,14 +142,15 @@ bool init(const std::string &db_path) {
             return false;
         }
     }
-    if (sqlite3_open(g_db_path.c_str(), &g_db) != SQLITE_OK) {
-        std::cerr << "SQLite open failed: " << sqlite3_errmsg(g_db) << "\n";
+    if (sqlite3_open(g_db_path.c_str(), &g_main.db) != SQLITE_OK) {
+        std::cerr << "SQLite open failed: " << sqlite3_errmsg(g_main.db) << "\n";
+        close_all();
         return false;
     }
-    sqlite3_busy_timeout(g_db, 5000);
-    sqlite3_exec(g_db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
-    sqlite3_exec(g_db, "PRAGMA synchronous=FULL;", nullptr, nullptr, nullptr);
-    sqlite3_exec(g_db, "PRAGMA foreign_keys=ON;", nullptr, nullptr, nullptr);
+    sqlite3_busy_timeout(g_main.db, 5000);
+    sqlite3_exec(g_main.db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(g_main.db, "PRAGMA synchronous=FULL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(g_main.db, "PRAGMA foreign_keys=ON;", nullptr, nullptr, nullptr);
         const char *schema =
         "PRAGMA journal_mode=WAL;"
         "CREATE TABLE IF NOT EXISTS accounts (\n"
@@ -96,68 +198,238 @@ bool init(const std::string &db_path) {
         ");"
     ;
     char *errmsg = nullptr;
-    if (sqlite3_exec(g_db, schema, nullptr, nullptr, &errmsg) != SQLITE_OK) {
+    if (sqlite3_exec(g_main.db, schema, nullptr, nullptr, &errmsg) != SQLITE_OK) {
         std::cerr << "SQLite schema error: " << (errmsg ? errmsg : "") << "\n";
         if (errmsg) sqlite3_free(errmsg);
+        close_all();
         return false;
     }
     // Ensure account_xp column on accounts (migration-safe: ignore error if exists)
-    sqlite3_exec(g_db, "ALTER TABLE accounts ADD COLUMN account_xp INTEGER NOT NULL DEFAULT 0;", nullptr, nullptr, nullptr);
+    sqlite3_exec(g_main.db, "ALTER TABLE accounts ADD COLUMN account_xp INTEGER NOT NULL DEFAULT 0;", nullptr, nullptr, nullptr);
 
     // meta table for db_instance_id and schema_version
-    sqlite3_exec(g_db, "CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value TEXT NOT NULL);", nullptr, nullptr, nullptr);
+    sqlite3_exec(g_main.db, "CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value TEXT NOT NULL);", nullptr, nullptr, nullptr);
     // db_instance_id
     {
-        sqlite3_stmt *s = nullptr;
-        if (sqlite3_prepare_v2(g_db, "SELECT value FROM meta WHERE key='db_instance_id' LIMIT 1", -1, &s, nullptr) == SQLITE_OK) {
+        Statement s(g_main, "SELECT value FROM meta WHERE key='db_instance_id' LIMIT 1");
+        if (s) {
             int rc = sqlite3_step(s);
-            sqlite3_finalize(s);
             if (rc != SQLITE_ROW) {
                 auto rnd = [](){ unsigned r = (unsigned) std::rand(); return r; };
                 auto hex16 = [](unsigned v){ char b[17]; std::snprintf(b, sizeof(b), "%08x", v); return std::string(b); };
                 std::string inst = hex16(rnd()) + hex16(rnd());
-                sqlite3_stmt *ins = nullptr;
-                if (sqlite3_prepare_v2(g_db, "INSERT OR REPLACE INTO meta (key, value) VALUES ('db_instance_id', ?1)", -1, &ins, nullptr) == SQLITE_OK) {
+                Statement ins(g_main, "INSERT OR REPLACE INTO meta (key, value) VALUES ('db_instance_id', ?1)");
+                if (ins) {
                     sqlite3_bind_text(ins, 1, inst.c_str(), -1, SQLITE_STATIC);
                     sqlite3_step(ins);
-                    sqlite3_finalize(ins);
                 }
             }
         }
     }
     // schema_version
     {
-        sqlite3_stmt *s = nullptr;
-        if (sqlite3_prepare_v2(g_db, "SELECT value FROM meta WHERE key='schema_version' LIMIT 1", -1, &s, nullptr) == SQLITE_OK) {
+        Statement s(g_main, "SELECT value FROM meta WHERE key='schema_version' LIMIT 1");
+        if (s) {
             int rc = sqlite3_step(s);
-            sqlite3_finalize(s);
             if (rc != SQLITE_ROW) {
-                sqlite3_exec(g_db, "INSERT OR REPLACE INTO meta (key, value) VALUES ('schema_version','1')", nullptr, nullptr, nullptr);
+                sqlite3_exec(g_main.db, "INSERT OR REPLACE INTO meta (key, value) VALUES ('schema_version','1')", nullptr, nullptr, nullptr);
             }
         }
     }
-    return true;
+    if (open_readers() && start_writer()) return true;
+    //g_main.db stays null, so the next call retries init instead of using a half-open database
+    close_all();
+    return false;
 }
 
 static bool is_valid_uuid(const std::string &s) {
     return s.size() == 36 && s[8]=='-' && s[13]=='-' && s[18]=='-' && s[23]=='-';
 }
 
+static void merge_pending(PendingWrites &into, PendingWrites const &from) {
+    into.xp += from.xp;
+    for (auto const &[mob_id, kills] : from.mob_kills) into.mob_kills[mob_id] += kills;
+    into.petals.insert(from.petals.begin(), from.petals.end());
+}
+
+//caller holds g_write_mu
+template <typename Fn>
+static void for_each_pending(const std::string &account_id, uint64_t db_seq, Fn &&fn) {
+    if (g_committing_seq > db_seq) {
+        auto it = g_committing.find(account_id);
+        if (it != g_committing.end()) fn(it->second);
+    }
+    auto it = g_queued.find(account_id);
+    if (it != g_queued.end()) fn(it->second);
+}
+
+//caller has a transaction open on conn, so this matches what its other reads saw
+static uint64_t read_write_seq(Connection &conn) {
+    Statement stmt(conn, "SELECT value FROM meta WHERE key='write_seq' LIMIT 1");
+    if (!stmt) return 0;
+    if (sqlite3_step(stmt) != SQLITE_ROW) return 0;
+    return (uint64_t) sqlite3_column_int64(stmt, 0);
+}
+
+//steps one write, returning the sqlite result code
+static int step_write(sqlite3_stmt *stmt) {
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc;
+}
+
+//one account's writes, inside its own savepoint so a failure only undoes that account
+static int apply_pending(const std::string &account_id, PendingWrites const &writes, std::time_t now) {
+    Statement xp(g_writer_conn, "UPDATE accounts SET account_xp = COALESCE(account_xp,0) + ?1, updated_at=?2 WHERE id=?3");
+    Statement kill(g_writer_conn,
+        "INSERT INTO mob_kills (account_id, mob_id, kills) VALUES (?1, ?2, ?3)\n"
+        "ON CONFLICT(account_id, mob_id) DO UPDATE SET kills = kills + excluded.kills");
+    Statement petal(g_writer_conn,
+        "INSERT INTO petal_obtained (account_id, petal_id, obtained) VALUES (?1, ?2, 1)\n"
+        "ON CONFLICT(account_id, petal_id) DO NOTHING");
+    if (!xp || !kill || !petal) return SQLITE_ERROR;
+    if (writes.xp != 0) {
+        sqlite3_bind_int(xp, 1, writes.xp);
+        sqlite3_bind_int64(xp, 2, now);
+        sqlite3_bind_text(xp, 3, account_id.c_str(), -1, SQLITE_STATIC);
+        int rc = step_write(xp);
+        if (rc != SQLITE_DONE) return rc;
+    }
+    for (auto const &[mob_id, kills] : writes.mob_kills) {
+        sqlite3_bind_text(kill, 1, account_id.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(kill, 2, mob_id);
+        sqlite3_bind_int(kill, 3, kills);
+        int rc = step_write(kill);
+        if (rc != SQLITE_DONE) return rc;
+    }
+    for (int petal_id : writes.petals) {
+        sqlite3_bind_text(petal, 1, account_id.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(petal, 2, petal_id);
+        int rc = step_write(petal);
+        if (rc != SQLITE_DONE) return rc;
+    }
+    return SQLITE_DONE;
+}
+
+//an account whose rows can never be written (e.g. it was deleted) is logged and dropped
+//other failures abort the batch so it can be retried whole
+static bool commit_batch(PendingMap const &batch, uint64_t seq) {
+    sqlite3 *db = g_writer_conn.db;
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "AuthDB: write-behind begin failed: " << sqlite3_errmsg(db) << "\n";
+        return false;
+    }
+    bool ok = true;
+    std::time_t now = std::time(nullptr);
+    for (auto const &[account_id, writes] : batch) {
+        ok = sqlite3_exec(db, "SAVEPOINT account", nullptr, nullptr, nullptr) == SQLITE_OK;
+        if (!ok) break;
+        int rc = apply_pending(account_id, writes, now);
+        if (rc != SQLITE_DONE && (rc & 0xff) == SQLITE_CONSTRAINT) {
+            std::cerr << "AuthDB: dropping writes for account " << account_id << ": " << sqlite3_errmsg(db) << "\n";
+            sqlite3_exec(db, "ROLLBACK TO account", nullptr, nullptr, nullptr);
+        } else if (rc != SQLITE_DONE) ok = false;
+        ok = sqlite3_exec(db, "RELEASE account", nullptr, nullptr, nullptr) == SQLITE_OK && ok;
+        if (!ok) break;
+    }
+    if (ok) {
+        Statement meta(g_writer_conn, "INSERT OR REPLACE INTO meta (key, value) VALUES ('write_seq', ?1)");
+        ok = meta;
+        if (ok) {
+            sqlite3_bind_int64(meta, 1, (sqlite3_int64) seq);
+            ok = sqlite3_step(meta) == SQLITE_DONE;
+        }
+    }
+    if (!ok) std::cerr << "AuthDB: write-behind batch failed: " << sqlite3_errmsg(db) << "\n";
+    ok = ok && sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) == SQLITE_OK;
+    if (!ok) sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+    return ok;
+}
+
+static void writer_main() {
+    std::unique_lock<std::mutex> lk(g_write_mu);
+    while (true) {
+        g_write_cv.wait_for(lk, WRITE_BEHIND_INTERVAL, [] { return g_writer_stop; });
+        if (g_queued.empty()) {
+            if (g_writer_stop) break;
+            continue;
+        }
+        g_committing.swap(g_queued);
+        g_committing_seq = g_next_seq++;
+        lk.unlock();
+        bool ok = commit_batch(g_committing, g_committing_seq);
+        lk.lock();
+        //failed writes go back in the queue for the next batch, unless there won't be one
+        if (!ok && !g_writer_stop)
+            for (auto const &[account_id, writes] : g_committing) merge_pending(g_queued[account_id], writes);
+        g_committing.clear();
+        g_committing_seq = 0;
+        if (!ok && g_writer_stop) break;
+    }
+}
+
+static void close_connection(Connection &conn) {
+    for (auto const &[sql, stmt] : conn.statements) sqlite3_finalize(stmt);
+    conn.statements.clear();
+    sqlite3_close(conn.db);
+    conn.db = nullptr;
+}
+
+//undoes a failed init
+static void close_all() {
+    {
+        std::lock_guard<std::mutex> lk(g_pool_mu);
+        for (std::unique_ptr<Connection> &conn : g_readers) close_connection(*conn);
+        g_readers.clear();
+        g_idle_readers.clear();
+    }
+    close_connection(g_writer_conn);
+    close_connection(g_main);
+}
+
+static bool open_readers() {
+    std::lock_guard<std::mutex> lk(g_pool_mu);
+    for (uint32_t i = 0; i < READ_POOL_SIZE; ++i) {
+        auto conn = std::make_unique<Connection>();
+        //each reader is only ever used by the thread holding it, so sqlite's own locking isn't needed
+        if (sqlite3_open_v2(g_db_path.c_str(), &conn->db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+            std::cerr << "AuthDB: reader connection failed: " << sqlite3_errmsg(conn->db) << "\n";
+            sqlite3_close(conn->db);
+            return false;
+        }
+        sqlite3_busy_timeout(conn->db, 5000);
+        g_idle_readers.push_back(conn.get());
+        g_readers.push_back(std::move(conn));
+    }
+    return true;
+}
+
+static bool start_writer() {
+    if (sqlite3_open(g_db_path.c_str(), &g_writer_conn.db) != SQLITE_OK) {
+        std::cerr << "AuthDB: writer connection failed: " << sqlite3_errmsg(g_writer_conn.db) << "\n";
+        return false;
+    }
+    sqlite3_busy_timeout(g_writer_conn.db, 5000);
+    sqlite3_exec(g_writer_conn.db, "PRAGMA synchronous=FULL;", nullptr, nullptr, nullptr);
+    sqlite3_exec(g_writer_conn.db, "PRAGMA foreign_keys=ON;", nullptr, nullptr, nullptr);
+    g_next_seq = read_write_seq(g_writer_conn) + 1;
+    g_writer = std::thread(writer_main);
+    return true;
+}
+
 bool upsert_account_for_discord(const std::string &discord_user_id, std::string &account_id_out) {
-    if (!g_db) {
+    if (!g_main.db) {
         if (!init("") ) return false;
     }
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(g_db, "SELECT account_id FROM discord_links WHERE discord_user_id=?1 LIMIT 1", -1, &stmt, nullptr) != SQLITE_OK) return false;
+    Statement stmt(g_main, "SELECT account_id FROM discord_links WHERE discord_user_id=?1 LIMIT 1");
+    if (!stmt) return false;
     sqlite3_bind_text(stmt, 1, discord_user_id.c_str(), -1, SQLITE_STATIC);
     int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         const char *acc = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
         if (acc) account_id_out.assign(acc);
-        sqlite3_finalize(stmt);
         return !account_id_out.empty();
     }
-    sqlite3_finalize(stmt);
     // Not found: create new account and link
     // Generate a UUID v4 (simple random-based implementation)
     auto rnd = [](){ unsigned r = (unsigned) std::rand(); return r; };
@@ -165,29 +437,27 @@ bool upsert_account_for_discord(const std::string &discord_user_id, std::string
     std::string u = hex16(rnd()) + "-" + hex16(rnd()).substr(0,4) + "-4" + hex16(rnd()).substr(0,3) + "-a" + hex16(rnd()).substr(0,3) + "-" + hex16(rnd()) + hex16(rnd());
     if (!is_valid_uuid(u)) return false;
     std::time_t now = std::time(nullptr);
-    sqlite3_exec(g_db, "BEGIN", nullptr, nullptr, nullptr);
-    sqlite3_stmt *ins1 = nullptr;
-    if (sqlite3_prepare_v2(g_db, "INSERT INTO accounts (id, created_at, updated_at, banned) VALUES (?1, ?2, ?2, 0)", -1, &ins1, nullptr) != SQLITE_OK) { sqlite3_exec(g_db, "ROLLBACK", nullptr, nullptr, nullptr); return false; }
+    sqlite3_exec(g_main.db, "BEGIN", nullptr, nullptr, nullptr);
+    Statement ins1(g_main, "INSERT INTO accounts (id, created_at, updated_at, banned) VALUES (?1, ?2, ?2, 0)");
+    if (!ins1) { sqlite3_exec(g_main.db, "ROLLBACK", nullptr, nullptr, nullptr); return false; }
     sqlite3_bind_text(ins1, 1, u.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int64(ins1, 2, now);
-    if (sqlite3_step(ins1) != SQLITE_DONE) { sqlite3_finalize(ins1); sqlite3_exec(g_db, "ROLLBACK", nullptr, nullptr, nullptr); return false; }
-    sqlite3_finalize(ins1);
+    if (sqlite3_step(ins1) != SQLITE_DONE) { sqlite3_exec(g_main.db, "ROLLBACK", nullptr, nullptr, nullptr); return false; }
 
-    sqlite3_stmt *ins2 = nullptr;
-    if (sqlite3_prepare_v2(g_db, "INSERT INTO discord_links (account_id, discord_user_id, created_at) VALUES (?1, ?2, ?3)", -1, &ins2, nullptr) != SQLITE_OK) { sqlite3_exec(g_db, "ROLLBACK", nullptr, nullptr, nullptr); return false; }
+    Statement ins2(g_main, "INSERT INTO discord_links (account_id, discord_user_id, created_at) VALUES (?1, ?2, ?3)");
+    if (!ins2) { sqlite3_exec(g_main.db, "ROLLBACK", nullptr, nullptr, nullptr); return false; }
     sqlite3_bind_text(ins2, 1, u.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(ins2, 2, discord_user_id.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int64(ins2, 3, now);
-    if (sqlite3_step(ins2) != SQLITE_DONE) { sqlite3_finalize(ins2); sqlite3_exec(g_db, "ROLLBACK", nullptr, nullptr, nullptr); return false; }
-    sqlite3_finalize(ins2);
+    if (sqlite3_step(ins2) != SQLITE_DONE) { sqlite3_exec(g_main.db, "ROLLBACK", nullptr, nullptr, nullptr); return false; }
 
-    sqlite3_exec(g_db, "COMMIT", nullptr, nullptr, nullptr);
+    sqlite3_exec(g_main.db, "COMMIT", nullptr, nullptr, nullptr);
     account_id_out = u;
     return true;
 }
 
 bool create_session(const std::string &account_id, int ttl_seconds, std::string &sid_out) {
-    if (!g_db) {
+    if (!g_main.db) {
         if (!init("") ) return false;
     }
     if (!is_valid_uuid(account_id)) return false;
@@ -200,19 +470,18 @@ bool create_session(const std::string &account_id, int ttl_seconds, std::string
 
     std::time_t now = std::time(nullptr);
     std::time_t exp = now + (ttl_seconds>0? ttl_seconds : 28800);
-    sqlite3_stmt *ins = nullptr;
-    if (sqlite3_prepare_v2(g_db, "INSERT INTO sessions (id, account_id, created_at, expires_at, revoked) VALUES (?1, ?2, ?3, ?4, 0)", -1, &ins, nullptr) != SQLITE_OK) return false;
+    Statement ins(g_main, "INSERT INTO sessions (id, account_id, created_at, expires_at, revoked) VALUES (?1, ?2, ?3, ?4, 0)");
+    if (!ins) return false;
     sqlite3_bind_text(ins, 1, sid_out.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(ins, 2, account_id.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int64(ins, 3, now);
     sqlite3_bind_int64(ins, 4, exp);
     bool ok = sqlite3_step(ins) == SQLITE_DONE;
-    sqlite3_finalize(ins);
     return ok;
 }
 
 bool validate_session_and_get_account(const std::string &sid, std::string &account_id_out) {
-    if (!g_db) {
+    if (!g_main.db) {
         if (!init("") ) return false;
     }
     // sid must be hex 64 (256-bit) to pass basic sanity
@@ -220,8 +489,10 @@ bool validate_session_and_get_account(const std::string &sid, std::string &accou
     // Query session
     const char *sql =
         "SELECT account_id, expires_at, revoked FROM sessions WHERE id = ?1 LIMIT 1";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+    ReadConnection conn;
+    if (!conn) return false;
+    Statement stmt(*conn, sql);
+    if (!stmt) return false;
     sqlite3_bind_text(stmt, 1, sid.c_str(), -1, SQLITE_STATIC);
     bool ok = false;
     int rc = sqlite3_step(stmt);
@@ -229,229 +500,213 @@ bool validate_session_and_get_account(const std::string &sid, std::string &accou
         const char *acc = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
         sqlite3_int64 exp = sqlite3_column_int64(stmt, 1);
         int revoked = sqlite3_column_int(stmt, 2);
-        sqlite3_finalize(stmt);
         if (!acc || std::strlen(acc) != 36) return false;
         std::time_t now = std::time(nullptr);
         if (revoked) return false;
         if (now > exp) return false;
         // Check ban
         const char *sql2 = "SELECT banned FROM accounts WHERE id = ?1 LIMIT 1";
-        sqlite3_stmt *stmt2 = nullptr;
-        if (sqlite3_prepare_v2(g_db, sql2, -1, &stmt2, nullptr) != SQLITE_OK) return false;
+        Statement stmt2(*conn, sql2);
+        if (!stmt2) return false;
         sqlite3_bind_text(stmt2, 1, acc, -1, SQLITE_STATIC);
         int rc2 = sqlite3_step(stmt2);
         if (rc2 == SQLITE_ROW) {
             int banned = sqlite3_column_int(stmt2, 0);
-            sqlite3_finalize(stmt2);
             if (banned) return false;
             account_id_out.assign(acc);
             ok = true;
-        } else {
-            sqlite3_finalize(stmt2);
         }
-    } else {
-        sqlite3_finalize(stmt);
     }
     return ok;
 }
 
 bool get_discord_username(const std::string &account_id, std::string &username_out) {
-    if (!g_db) {
+    if (!g_main.db) {
         if (!init("") ) return false;
     }
     // For backwards compatibility, return the discord_user_id if username table not present.
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(g_db, "SELECT discord_user_id FROM discord_links WHERE account_id=?1 LIMIT 1", -1, &stmt, nullptr) != SQLITE_OK) return false;
+    ReadConnection conn;
+    if (!conn) return false;
+    Statement stmt(*conn, "SELECT discord_user_id FROM discord_links WHERE account_id=?1 LIMIT 1");
+    if (!stmt) return false;
     sqlite3_bind_text(stmt, 1, account_id.c_str(), -1, SQLITE_STATIC);
     int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         const char *did = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
         if (did) username_out.assign(did);
-        sqlite3_finalize(stmt);
         return !username_out.empty();
     }
-    sqlite3_finalize(stmt);
     return false;
 }
 
 bool get_discord_info(const std::string &account_id, std::string &discord_id_out, std::string &username_out) {
     discord_id_out.clear();
     username_out.clear();
-    if (!g_db) { if (!init("") ) return false; }
+    if (!g_main.db) { if (!init("") ) return false; }
     // First get the discord id from the link
-    sqlite3_stmt *s1 = nullptr;
-    if (sqlite3_prepare_v2(g_db, "SELECT discord_user_id FROM discord_links WHERE account_id=?1 LIMIT 1", -1, &s1, nullptr) != SQLITE_OK) return false;
+    ReadConnection conn;
+    if (!conn) return false;
+    Statement s1(*conn, "SELECT discord_user_id FROM discord_links WHERE account_id=?1 LIMIT 1");
+    if (!s1) return false;
     sqlite3_bind_text(s1, 1, account_id.c_str(), -1, SQLITE_STATIC);
     int rc1 = sqlite3_step(s1);
     if (rc1 == SQLITE_ROW) {
         const char *did = reinterpret_cast<const char *>(sqlite3_column_text(s1, 0));
         if (did) discord_id_out.assign(did);
     }
-    sqlite3_finalize(s1);
     if (discord_id_out.empty()) return false;
     // Then try to fetch username from users table if present
-    sqlite3_stmt *s2 = nullptr;
-    if (sqlite3_prepare_v2(g_db, "SELECT username FROM users WHERE discord_id=?1 LIMIT 1", -1, &s2, nullptr) == SQLITE_OK) {
+    Statement s2(*conn, "SELECT username FROM users WHERE discord_id=?1 LIMIT 1");
+    if (s2) {
         sqlite3_bind_text(s2, 1, discord_id_out.c_str(), -1, SQLITE_STATIC);
         int rc2 = sqlite3_step(s2);
         if (rc2 == SQLITE_ROW) {
             const unsigned char *u = sqlite3_column_text(s2, 0);
             if (u) username_out.assign(reinterpret_cast<const char *>(u));
         }
-        sqlite3_finalize(s2);
     }
     return true;
 }
 
 
-bool record_mob_kill(const std::string &account_id, int mob_id) {
-    if (!g_db) { if (!init("") ) return false; }
+bool record_mob_kill(const std::string &account_id, int mob_id, int kills) {
+    if (!g_main.db) { if (!init("") ) return false; }
     if (!is_valid_uuid(account_id)) return false;
-    std::cout << "AuthDB: record_mob_kill account_id=" << account_id << ", mob_id=" << mob_id << "\n";
-    sqlite3_stmt *stmt = nullptr;
-    const char *sql =
-        "INSERT INTO mob_kills (account_id, mob_id, kills) VALUES (?1, ?2, 1)\n"
-        "ON CONFLICT(account_id, mob_id) DO UPDATE SET kills = kills + 1";
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "AuthDB: failed to prepare record_mob_kill: " << sqlite3_errmsg(g_db) << "\n";
-        return false;
-    }
-    sqlite3_bind_text(stmt, 1, account_id.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 2, mob_id);
-    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    if (!ok) {
-        std::cerr << "AuthDB: record_mob_kill step failed: " << sqlite3_errmsg(g_db) << "\n";
-    }
-    sqlite3_finalize(stmt);
-    return ok;
+    std::cout << "AuthDB: record_mob_kill account_id=" << account_id << ", mob_id=" << mob_id << ", kills=" << kills << "\n";
+    std::lock_guard<std::mutex> lk(g_write_mu);
+    g_queued[account_id].mob_kills[mob_id] += kills;
+    return true;
 }
 
 
 bool get_mob_ids(const std::string &account_id, std::vector<int> &mob_ids_out) {
     mob_ids_out.clear();
-    if (!g_db) { if (!init("") ) return false; }
+    if (!g_main.db) { if (!init("") ) return false; }
     if (!is_valid_uuid(account_id)) return false;
     const char *sql = "SELECT mob_id FROM mob_kills WHERE account_id=?1";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "AuthDB: get_mob_ids prepare failed: " << sqlite3_errmsg(g_db) << "\n";
+    std::lock_guard<std::mutex> lk(g_write_mu);
+    ReadConnection conn;
+    if (!conn) return false;
+    Statement stmt(*conn, sql);
+    if (!stmt) {
+        std::cerr << "AuthDB: get_mob_ids prepare failed: " << sqlite3_errmsg((*conn).db) << "\n";
         return false;
     }
+    sqlite3_exec((*conn).db, "BEGIN", nullptr, nullptr, nullptr);
     sqlite3_bind_text(stmt, 1, account_id.c_str(), -1, SQLITE_STATIC);
-    int rows = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int mob_id = sqlite3_column_int(stmt, 0);
-        mob_ids_out.push_back(mob_id);
-        rows++;
-    }
-    sqlite3_finalize(stmt);
-    std::cout << "AuthDB: get_mob_ids account_id=" << account_id << " -> count=" << rows << "\n";
+    std::set<int> seen;
+    while (sqlite3_step(stmt) == SQLITE_ROW) seen.insert(sqlite3_column_int(stmt, 0));
+    uint64_t db_seq = read_write_seq(*conn);
+    sqlite3_exec((*conn).db, "COMMIT", nullptr, nullptr, nullptr);
+    for_each_pending(account_id, db_seq, [&](PendingWrites const &p) {
+        for (auto const &[mob_id, kills] : p.mob_kills) seen.insert(mob_id);
+    });
+    mob_ids_out.assign(seen.begin(), seen.end());
+    std::cout << "AuthDB: get_mob_ids account_id=" << account_id << " -> count=" << mob_ids_out.size() << "\n";
     return true;
 }
 
 
 
 bool record_petal_obtained(const std::string &account_id, int petal_id) {
-    if (!g_db) { if (!init("") ) return false; }
+    if (!g_main.db) { if (!init("") ) return false; }
     if (!is_valid_uuid(account_id)) return false;
     if (petal_id < 0) return false;
-    sqlite3_stmt *stmt = nullptr;
-    const char *sql =
-        "INSERT INTO petal_obtained (account_id, petal_id, obtained) VALUES (?1, ?2, 1)\n"
-        "ON CONFLICT(account_id, petal_id) DO NOTHING";
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "AuthDB: failed to prepare record_petal_obtained: " << sqlite3_errmsg(g_db) << "\n";
-        return false;
-    }
-    sqlite3_bind_text(stmt, 1, account_id.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 2, petal_id);
-    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return ok;
+    std::lock_guard<std::mutex> lk(g_write_mu);
+    g_queued[account_id].petals.insert(petal_id);
+    return true;
 }
 
 bool get_petal_ids(const std::string &account_id, std::vector<int> &petal_ids_out) {
     petal_ids_out.clear();
-    if (!g_db) { if (!init("") ) return false; }
+    if (!g_main.db) { if (!init("") ) return false; }
     if (!is_valid_uuid(account_id)) return false;
     const char *sql = "SELECT petal_id FROM petal_obtained WHERE account_id=?1";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "AuthDB: get_petal_ids prepare failed: " << sqlite3_errmsg(g_db) << "\n";
+    std::lock_guard<std::mutex> lk(g_write_mu);
+    ReadConnection conn;
+    if (!conn) return false;
+    Statement stmt(*conn, sql);
+    if (!stmt) {
+        std::cerr << "AuthDB: get_petal_ids prepare failed: " << sqlite3_errmsg((*conn).db) << "\n";
         return false;
     }
+    sqlite3_exec((*conn).db, "BEGIN", nullptr, nullptr, nullptr);
     sqlite3_bind_text(stmt, 1, account_id.c_str(), -1, SQLITE_STATIC);
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int petal_id = sqlite3_column_int(stmt, 0);
-        petal_ids_out.push_back(petal_id);
-    }
-    sqlite3_finalize(stmt);
+    std::set<int> seen;
+    while (sqlite3_step(stmt) == SQLITE_ROW) seen.insert(sqlite3_column_int(stmt, 0));
+    uint64_t db_seq = read_write_seq(*conn);
+    sqlite3_exec((*conn).db, "COMMIT", nullptr, nullptr, nullptr);
+    for_each_pending(account_id, db_seq, [&](PendingWrites const &p) {
+        seen.insert(p.petals.begin(), p.petals.end());
+    });
+    petal_ids_out.assign(seen.begin(), seen.end());
     return true;
 }
 
 // ---------------- Account XP -----------------
 bool add_account_xp(const std::string &account_id, int xp) {
-    if (!g_db) { if (!init("") ) return false; }
+    if (!g_main.db) { if (!init("") ) return false; }
     if (!is_valid_uuid(account_id)) return false;
-    std::time_t now = std::time(nullptr);
-    sqlite3_stmt *stmt = nullptr;
-    const char *sql = "UPDATE accounts SET account_xp = COALESCE(account_xp,0) + ?1, updated_at=?2 WHERE id=?3";
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "AuthDB: add_account_xp prepare failed: " << sqlite3_errmsg(g_db) << "\n";
-        return false;
-    }
-    sqlite3_bind_int(stmt, 1, xp);
-    sqlite3_bind_int64(stmt, 2, now);
-    sqlite3_bind_text(stmt, 3, account_id.c_str(), -1, SQLITE_STATIC);
-    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
-    sqlite3_finalize(stmt);
-    return ok;
+    std::lock_guard<std::mutex> lk(g_write_mu);
+    g_queued[account_id].xp += xp;
+    return true;
 }
 
 bool get_account_xp(const std::string &account_id, int &xp_out) {
     xp_out = 0;
-    if (!g_db) { if (!init("") ) return false; }
+    if (!g_main.db) { if (!init("") ) return false; }
     if (!is_valid_uuid(account_id)) return false;
-    sqlite3_stmt *stmt = nullptr;
     const char *sql = "SELECT account_xp FROM accounts WHERE id=?1 LIMIT 1";
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "AuthDB: get_account_xp prepare failed: " << sqlite3_errmsg(g_db) << "\n";
+    std::lock_guard<std::mutex> lk(g_write_mu);
+    ReadConnection conn;
+    if (!conn) return false;
+    Statement stmt(*conn, sql);
+    if (!stmt) {
+        std::cerr << "AuthDB: get_account_xp prepare failed: " << sqlite3_errmsg((*conn).db) << "\n";
         return false;
     }
+    sqlite3_exec((*conn).db, "BEGIN", nullptr, nullptr, nullptr);
     sqlite3_bind_text(stmt, 1, account_id.c_str(), -1, SQLITE_STATIC);
-    int rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW) {
-        xp_out = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
-        return true;
-    }
-    sqlite3_finalize(stmt);
     // If account row missing (shouldn't happen), treat as 0
-    xp_out = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) xp_out = sqlite3_column_int(stmt, 0);
+    uint64_t db_seq = read_write_seq(*conn);
+    sqlite3_exec((*conn).db, "COMMIT", nullptr, nullptr, nullptr);
+    for_each_pending(account_id, db_seq, [&](PendingWrites const &p) { xp_out += p.xp; });
     return true;
 }
 
 
 bool get_top_account_by_xp(std::string &account_id_out) {
     account_id_out.clear();
-    if (!g_db) { if (!init("") ) return false; }
+    if (!g_main.db) { if (!init("") ) return false; }
     const char *sql = "SELECT id FROM accounts ORDER BY account_xp DESC LIMIT 1";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(g_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "AuthDB: get_top_account_by_xp prepare failed: " << sqlite3_errmsg(g_db) << "\n";
+    ReadConnection conn;
+    if (!conn) return false;
+    Statement stmt(*conn, sql);
+    if (!stmt) {
+        std::cerr << "AuthDB: get_top_account_by_xp prepare failed: " << sqlite3_errmsg((*conn).db) << "\n";
         return false;
     }
     int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         const char *acc = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
         if (acc) account_id_out.assign(acc);
-        sqlite3_finalize(stmt);
         return !account_id_out.empty();
     }
-    sqlite3_finalize(stmt);
     return false;
 }
 
+void shutdown() {
+    if (!g_writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(g_write_mu);
+        g_writer_stop = true;
+    }
+    g_write_cv.notify_all();
+    g_writer.join();
+    close_connection(g_writer_conn);
+}
+
 } // namespace AuthDB
 
 
@@ -24,9 +24,11 @@ namespace AuthDB {
     // Fetch discord id and username by account id. Returns true if discord id found.
     bool get_discord_info(const std::string &account_id, std::string &discord_id_out, std::string &username_out);
 
-    // Record a mob kill for this account. mob_id is the numeric MobID::T.
-    // Returns true on success.
-    bool record_mob_kill(const std::string &account_id, int mob_id);
+    // Kills, petals and xp below are queued and committed in batches by a writer thread,
+    // so recording never waits on disk. Returns true once queued. Reads include queued writes.
+
+    // Record kills of a mob for this account. mob_id is the numeric MobID::T.
+    bool record_mob_kill(const std::string &account_id, int mob_id, int kills = 1);
 
     // Fetch list of mob_ids this account has killed/seen. Returns true on success.
     bool get_mob_ids(const std::string &account_id, std::vector<int> &mob_ids_out);
@@ -43,6 +45,9 @@ namespace AuthDB {
 
     // Returns the account id with highest total account_xp. True if found.
     bool get_top_account_by_xp(std::string &account_id_out);
+
+    // Commits everything still queued and stops the writer thread.
+    void shutdown();
 }
 
 
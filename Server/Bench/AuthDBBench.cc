@@ -0,0 +1,160 @@
+//queries per second for the lookups the server makes against AuthDB
+//uncached: one shared connection, prepared and finalized on every call, as AuthDB used to do
+//cached: the AuthDB API, with statements kept per connection and reads spread over the pool
+#include <Server/AuthDB.hh>
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static uint32_t const ACCOUNTS = 1000;
+static uint32_t const MOBS_PER_ACCOUNT = 20;
+
+static std::vector<std::string> accounts;
+static std::vector<std::string> sessions;
+
+static std::string _uuid(uint32_t i) {
+    char b[37];
+    std::snprintf(b, sizeof(b), "%08x-0000-4000-a000-%012x", i, i);
+    return b;
+}
+
+static bool _uncached_validate(sqlite3 *db, std::string const &sid, std::string &account_id_out) {
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT account_id, expires_at, revoked FROM sessions WHERE id = ?1 LIMIT 1", -1, &stmt, nullptr) != SQLITE_OK) return false;
+    sqlite3_bind_text(stmt, 1, sid.c_str(), -1, SQLITE_STATIC);
+    bool ok = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW && !sqlite3_column_int(stmt, 2)) {
+        std::string acc(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+        sqlite3_stmt *stmt2 = nullptr;
+        if (sqlite3_prepare_v2(db, "SELECT banned FROM accounts WHERE id = ?1 LIMIT 1", -1, &stmt2, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(stmt2, 1, acc.c_str(), -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt2) == SQLITE_ROW && !sqlite3_column_int(stmt2, 0)) {
+                account_id_out = acc;
+                ok = true;
+            }
+            sqlite3_finalize(stmt2);
+        }
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+static bool _uncached_xp(sqlite3 *db, std::string const &account_id, int &xp_out) {
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT account_xp FROM accounts WHERE id=?1 LIMIT 1", -1, &stmt, nullptr) != SQLITE_OK) return false;
+    sqlite3_bind_text(stmt, 1, account_id.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) == SQLITE_ROW) xp_out = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+static bool _uncached_mob_ids(sqlite3 *db, std::string const &account_id, std::vector<int> &mob_ids_out) {
+    mob_ids_out.clear();
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT mob_id FROM mob_kills WHERE account_id=?1", -1, &stmt, nullptr) != SQLITE_OK) return false;
+    sqlite3_bind_text(stmt, 1, account_id.c_str(), -1, SQLITE_STATIC);
+    while (sqlite3_step(stmt) == SQLITE_ROW) mob_ids_out.push_back(sqlite3_column_int(stmt, 0));
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+static void _fixture(std::string const &path) {
+    sqlite3 *db;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+    for (uint32_t i = 0; i < ACCOUNTS; ++i) {
+        accounts.push_back(_uuid(i));
+        std::string const &a = accounts.back();
+        sqlite3_exec(db, ("INSERT INTO accounts (id, created_at, updated_at, banned, account_xp) VALUES ('"
+            + a + "', 0, 0, 0, " + std::to_string(i) + ")").c_str(), nullptr, nullptr, nullptr);
+        for (uint32_t m = 0; m < MOBS_PER_ACCOUNT; ++m)
+            sqlite3_exec(db, ("INSERT INTO mob_kills (account_id, mob_id, kills) VALUES ('"
+                + a + "', " + std::to_string(m) + ", 1)").c_str(), nullptr, nullptr, nullptr);
+    }
+    sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+    for (std::string const &a : accounts) {
+        std::string sid;
+        AuthDB::create_session(a, 3600, sid);
+        sessions.push_back(sid);
+    }
+}
+
+static double _qps(uint32_t n, std::function<void(uint32_t)> const &query) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n; ++i) query(i);
+    return n / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//session checks from several threads while the game floods xp writes
+static double _contended_qps(uint32_t threads, double seconds, std::function<void(uint32_t)> const &query) {
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> done = 0;
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            uint64_t count = 0;
+            for (uint32_t i = t; !stop; i += threads, ++count) query(i);
+            done += count;
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds; ++i)
+        AuthDB::add_account_xp(accounts[i % ACCOUNTS], 1);
+    stop = true;
+    for (std::thread &w : workers) w.join();
+    return done / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void _report(char const *name, double uncached, double cached) {
+    std::printf("  %-28s %10.0f %10.0f  x%.1f\n", name, uncached, cached, cached / uncached);
+}
+
+int main(int argc, char **argv) {
+    std::string path = argc > 1 ? argv[1] : "authdb-bench.db";
+    uint32_t n = argc > 2 ? std::atoi(argv[2]) : 50000;
+    uint32_t threads = argc > 3 ? std::atoi(argv[3]) : 4;
+    for (char const *suffix : { "", "-wal", "-shm" }) std::filesystem::remove(path + suffix);
+    setenv("ALLOW_INIT_DB", "1", 1);
+    if (!AuthDB::init(path)) return 1;
+    _fixture(path);
+
+    sqlite3 *db;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_busy_timeout(db, 5000);
+    //AuthDB logs every gallery lookup
+    std::cout.setstate(std::ios::failbit);
+    std::string acc;
+    int xp;
+    std::vector<int> ids;
+    double results[8] = {
+        _qps(n, [&](uint32_t i) { _uncached_validate(db, sessions[i % ACCOUNTS], acc); }),
+        _qps(n, [&](uint32_t i) { AuthDB::validate_session_and_get_account(sessions[i % ACCOUNTS], acc); }),
+        _qps(n, [&](uint32_t i) { _uncached_xp(db, accounts[i % ACCOUNTS], xp); }),
+        _qps(n, [&](uint32_t i) { AuthDB::get_account_xp(accounts[i % ACCOUNTS], xp); }),
+        _qps(n, [&](uint32_t i) { _uncached_mob_ids(db, accounts[i % ACCOUNTS], ids); }),
+        _qps(n, [&](uint32_t i) { AuthDB::get_mob_ids(accounts[i % ACCOUNTS], ids); }),
+        _contended_qps(threads, 2, [&](uint32_t i) { std::string a; _uncached_validate(db, sessions[i % ACCOUNTS], a); }),
+        _contended_qps(threads, 2, [&](uint32_t i) { std::string a; AuthDB::validate_session_and_get_account(sessions[i % ACCOUNTS], a); }),
+    };
+    std::cout.clear();
+    std::printf("%u accounts, %u queries, %u threads under write load\n", ACCOUNTS, n, threads);
+    std::printf("  %-28s %10s %10s\n", "qps", "uncached", "cached");
+    _report("validate_session", results[0], results[1]);
+    _report("get_account_xp", results[2], results[3]);
+    _report("get_mob_ids", results[4], results[5]);
+    _report("validate_session, threaded", results[6], results[7]);
+    sqlite3_close(db);
+    AuthDB::shutdown();
+    return 0;
+}
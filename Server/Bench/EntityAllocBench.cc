@@ -0,0 +1,78 @@
+//random delete+alloc pairs at a fixed occupancy, through Simulation::alloc_ent and through
+//the linear scan it replaced; both sides go through the same init and delete
+#include <Shared/Simulation.hh>
+#include <Shared/Entity.hh>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static Simulation simulation;
+
+//alloc_ent before the free bitset: a walk over the tracker from id 1, mirrored here since
+//the simulation's own tracker is private; force_alloc_ent then does the same init alloc_ent does
+static std::array<uint8_t, div_round_up(ENTITY_CAP, 8)> tracker;
+static std::array<EntityID::hash_type, ENTITY_CAP> hashes;
+
+static Entity &_scan_alloc() {
+    for (EntityID::id_type i = 1; i < ENTITY_CAP; ++i) {
+        if (BitMath::at_arr(tracker.data(), i)) continue;
+        BitMath::set_arr(tracker.data(), i);
+        EntityID const id(i, hashes[i]);
+        simulation.force_alloc_ent(id);
+        return simulation.get_ent(id);
+    }
+    std::abort();
+}
+
+static void _scan_delete(EntityID const &id) {
+    simulation._delete_ent(id);
+    BitMath::unset_arr(tracker.data(), id.id);
+    ++hashes[id.id];
+}
+
+static Entity &_bitset_alloc() {
+    return simulation.alloc_ent();
+}
+
+static void _bitset_delete(EntityID const &id) {
+    simulation._delete_ent(id);
+}
+
+//ids are filled from 1 up, like the pre-spawned mobs, then random live ids are swapped out
+template <typename Alloc, typename Delete>
+static double _ns_per_pair(uint32_t live, uint32_t pairs, Alloc &&alloc, Delete &&del) {
+    simulation.reset();
+    tracker = {0};
+    hashes = {0};
+    std::vector<EntityID> ids;
+    for (uint32_t i = 0; i < live; ++i) ids.push_back(alloc().id);
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint32_t> pick(0, live - 1);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < pairs; ++n) {
+        EntityID &slot = ids[pick(rng)];
+        del(slot);
+        slot = alloc().id;
+    }
+    auto end = std::chrono::steady_clock::now();
+    for (EntityID const &id : ids) del(id);
+    return std::chrono::duration<double, std::nano>(end - start).count() / pairs;
+}
+
+int main(int argc, char **argv) {
+    uint32_t pairs = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::cout << ENTITY_CAP << " ids, " << pairs << " delete+alloc pairs\n";
+    std::cout << "  occupancy   scan ns   bitset ns\n";
+    for (uint32_t percent : { 10, 50, 95 }) {
+        uint32_t live = ENTITY_CAP * percent / 100;
+        double scan = _ns_per_pair(live, pairs, _scan_alloc, _scan_delete);
+        double bitset = _ns_per_pair(live, pairs, _bitset_alloc, _bitset_delete);
+        std::printf("  %8u%% %9.0f %11.0f\n", percent, scan, bitset);
+    }
+    return 0;
+}
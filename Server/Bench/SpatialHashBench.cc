@@ -0,0 +1,114 @@
+//replays an entity distribution through whichever SpatialHash this binary
+//was built with (spatial-hash-bench-canonical / spatial-hash-bench-uniform)
+//distribution files are plain text, one "x y radius" line per entity
+#include <Server/SpatialHash.hh>
+
+#include <Shared/Simulation.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+struct BenchEntity {
+    float x;
+    float y;
+    float radius;
+};
+
+static Simulation simulation;
+
+static std::vector<BenchEntity> _load(std::string const &path) {
+    std::vector<BenchEntity> ents;
+    std::ifstream in(path);
+    BenchEntity e;
+    while (in >> e.x >> e.y >> e.radius) ents.push_back(e);
+    return ents;
+}
+
+//clustered like ant holes and zone spawns, with a few large mobs mixed in
+static std::vector<BenchEntity> _synthesize(uint32_t count) {
+    std::vector<BenchEntity> ents;
+    srand(1);
+    for (uint32_t i = 0; i < count; ++i) {
+        float cx = (i % 40) * ARENA_WIDTH / 40.0f + 250;
+        float cy = (i % 7) * ARENA_HEIGHT / 7.0f + 250;
+        Vector off = Vector::rand(frand() * 600);
+        float radius = frand() < 0.02 ? 150 + frand() * 150 : 15 + frand() * 40;
+        ents.push_back({ (float) fclamp(cx + off.x, 0, ARENA_WIDTH), (float) fclamp(cy + off.y, 0, ARENA_HEIGHT), radius });
+    }
+    return ents;
+}
+
+template <typename F>
+static double _time_us(uint32_t reps, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < reps; ++i) f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / reps;
+}
+
+int main(int argc, char **argv) {
+    std::string path = argc > 1 ? argv[1] : "spatial_hash_distribution.txt";
+    std::vector<BenchEntity> dist = _load(path);
+    if (dist.empty()) {
+        dist = _synthesize(4000);
+        std::ofstream out(path);
+        out.precision(std::numeric_limits<float>::max_digits10);
+        for (BenchEntity const &e : dist) out << e.x << ' ' << e.y << ' ' << e.radius << '\n';
+        std::cout << "wrote synthesized distribution to " << path << '\n';
+    }
+    #ifdef GENERAL_SPATIAL_HASH
+    std::cout << "SpatialHashCanonical, " << dist.size() << " entities\n";
+    #else
+    std::cout << "SpatialHashUniform, " << dist.size() << " entities\n";
+    //the uniform grid cannot hold anything larger than GRID_SIZE / 2
+    for (BenchEntity &e : dist) e.radius = std::min(e.radius, GRID_SIZE / 2.0f);
+    #endif
+
+    std::vector<Entity *> ents;
+    for (BenchEntity const &e : dist) {
+        Entity &ent = simulation.alloc_ent();
+        ent.add_component(kPhysics);
+        ent.set_x(e.x);
+        ent.set_y(e.y);
+        ent.set_radius(e.radius);
+        ents.push_back(&ent);
+    }
+
+    uint32_t pairs = 0;
+    uint32_t hits = 0;
+    auto insert_all = [&]() { for (Entity *ent : ents) simulation.spatial_hash.insert(*ent); };
+    auto collide = [&]() {
+        pairs = 0;
+        simulation.spatial_hash.collide([&](Simulation *, Entity &, Entity &) { ++pairs; });
+    };
+    //camera sized windows centered on every 16th entity
+    auto query = [&]() {
+        hits = 0;
+        for (uint32_t i = 0; i < ents.size(); i += 16)
+            simulation.spatial_hash.query(ents[i]->get_x(), ents[i]->get_y(), 960, 540, [&](Simulation *, Entity &) { ++hits; });
+    };
+    //alternate between two offsets so every entity changes cells and forces a rebuild
+    uint32_t flip = 0;
+    auto move_all = [&]() {
+        float d = (flip ^= 1) ? GRID_SIZE : -(float) GRID_SIZE;
+        for (Entity *ent : ents) ent->set_x(fclamp(ent->get_x() + d, 0, ARENA_WIDTH));
+        insert_all();
+        collide();
+    };
+
+    insert_all();
+    collide();
+    query();
+    std::cout << "  collide pairs:        " << pairs << '\n';
+    std::cout << "  query hits:           " << hits << '\n';
+    std::cout << "  insert (unchanged) us " << _time_us(200, insert_all) << '\n';
+    std::cout << "  collide us            " << _time_us(200, collide) << '\n';
+    std::cout << "  queries us            " << _time_us(200, query) << '\n';
+    std::cout << "  move+rebuild+collide  " << _time_us(200, move_all) << '\n';
+    return 0;
+}
@@ -0,0 +1,126 @@
+//runs the arena with fake clients, records every packet they would be sent,
+//then replays them through raw deflate the way permessage-deflate would
+//shared: fresh window per message, as uWS::SHARED_COMPRESSOR
+//dedicated: one sliding window per client, as the uWS::DEDICATED_COMPRESSOR_* modes
+#include <Server/Client.hh>
+#include <Server/Server.hh>
+
+#include <Shared/Entity.hh>
+#include <Shared/Simulation.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+typedef std::vector<uint8_t> Message;
+
+WebSocketServer Server::server;
+void Server::run() {}
+
+static std::map<Client const *, std::vector<Message>> sent;
+
+void Client::send_packet(uint8_t const *packet, size_t size) {
+    sent[this].emplace_back(packet, packet + size);
+}
+
+struct CompressMode {
+    char const *name;
+    uint8_t dedicated;
+    int window_bits;
+    int mem_level;
+};
+
+struct CompressResult {
+    uint64_t bytes = 0;
+    uint64_t compressed = 0;
+    double us = 0;
+};
+
+static CompressMode const MODES[] = {
+    { "shared                  ", 0, 15, 8 },
+    { "dedicated, 512B window  ", 1, 9, 1 },
+    { "dedicated, 32KB window  ", 1, 15, 8 },
+};
+
+//compressed size of one permessage-deflate frame, without the trailing 00 00 ff ff
+static uint32_t _deflate(z_stream &stream, Message const &msg) {
+    static std::vector<uint8_t> out(2 * MAX_PACKET_LEN);
+    stream.next_in = const_cast<uint8_t *>(msg.data());
+    stream.avail_in = msg.size();
+    stream.next_out = out.data();
+    stream.avail_out = out.size();
+    deflate(&stream, Z_SYNC_FLUSH);
+    return out.size() - stream.avail_out - 4;
+}
+
+static CompressResult _replay(std::vector<std::vector<Message> const *> const &clients, CompressMode const &mode) {
+    CompressResult res;
+    for (std::vector<Message> const *msgs : clients) {
+        z_stream stream = {};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -mode.window_bits, mode.mem_level, Z_DEFAULT_STRATEGY);
+        for (Message const &msg : *msgs) {
+            res.bytes += msg.size();
+            if (msg.size() < COMPRESS_MIN_BYTES) {
+                res.compressed += msg.size();
+                continue;
+            }
+            auto start = std::chrono::steady_clock::now();
+            if (!mode.dedicated) deflateReset(&stream);
+            uint32_t size = _deflate(stream, msg);
+            res.us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            res.compressed += std::min<uint32_t>(size, msg.size());
+        }
+        deflateEnd(&stream);
+    }
+    return res;
+}
+
+int main(int argc, char **argv) {
+    uint32_t client_count = argc > 1 ? std::atoi(argv[1]) : 64;
+    uint32_t ticks = argc > 2 ? std::atoi(argv[2]) : 20 * TPS;
+    srand(1);
+    Server::game.init();
+    //half spread over the map, half joining the same spot, like a spawn into a busy zone
+    std::vector<Client *> clients;
+    for (uint32_t i = 0; i < client_count; ++i) {
+        Client *client = new Client();
+        client->verified = 1;
+        Server::game.add_client(client);
+        Entity &camera = Server::game.simulation.get_ent(client->camera);
+        if (i % 2) {
+            camera.set_camera_x(ARENA_WIDTH / 2 + (i % 8) * 100);
+            camera.set_camera_y(ARENA_HEIGHT / 2 + (i % 5) * 100);
+        } else {
+            camera.set_camera_x(frand() * ARENA_WIDTH);
+            camera.set_camera_y(frand() * ARENA_HEIGHT);
+        }
+        clients.push_back(client);
+    }
+    for (uint32_t i = 0; i < ticks; ++i) Server::game.tick();
+
+    std::vector<std::vector<Message> const *> streams;
+    uint64_t messages = 0;
+    for (Client *client : clients) {
+        streams.push_back(&sent[client]);
+        messages += sent[client].size();
+    }
+    double const seconds = (double) ticks / TPS;
+    double const per_client = 1.0 / client_count / seconds;
+    uint64_t raw = 0;
+    for (std::vector<Message> const *msgs : streams)
+        for (Message const &msg : *msgs) raw += msg.size();
+    std::cout << client_count << " clients, " << seconds << " s, " << messages << " messages\n";
+    std::cout << "  raw                     " << (uint64_t) (raw * per_client) << " B/client/s\n";
+    for (CompressMode const &mode : MODES) {
+        CompressResult res = _replay(streams, mode);
+        std::cout << "  " << mode.name << (uint64_t) (res.compressed * per_client) << " B/client/s, "
+            << 100.0 * res.compressed / res.bytes << "% of raw, "
+            << res.us / 1000 / seconds << " ms cpu per second of play\n";
+    }
+    return 0;
+}
@@ -73,13 +73,11 @@ void spawn_all(Simulation *sim, uint32_t count) {
     g_bots.reserve(count);
     for (uint32_t i = 0; i < count; ++i) {
         Entity &cam = alloc_cpu_camera(sim, NULL_ENTITY);
-        BitMath::set(cam.flags, EntityFlags::kCPUControlled);
+        BitMath::set(cam.flags(), EntityFlags::kCPUControlled);
         cam.set_fov(BASE_FOV * (0.95f + 0.1f * frand_s()));
         ensure_has_player(sim, cam);
-        { std::string acc = std::string("bot:") + std::to_string((uint32_t)cam.id.id);
-          AccountLink::map_camera(cam.id, acc);
-          if (sim->ent_alive(cam.get_player())) AccountLink::map_player(cam.get_player(), acc);
-        }
+        AccountLink::map_bot(cam.id);
+        if (sim->ent_alive(cam.get_player())) AccountLink::map_bot(cam.get_player());
         BotState s{};
         s.camera = cam.id;
         choose_new_roam_target(s, sim);
@@ -94,12 +92,10 @@ void on_tick(Simulation *sim) {
     for (BotState &b : g_bots) {
         if (!sim->ent_alive(b.camera)) continue;
         Entity &cam = sim->get_ent(b.camera);
-        if (!BitMath::at(cam.flags, EntityFlags::kCPUControlled)) continue;
+        if (!BitMath::at(cam.flags(), EntityFlags::kCPUControlled)) continue;
         ensure_has_player(sim, cam);
-        { std::string acc = std::string("bot:") + std::to_string((uint32_t)cam.id.id);
-          AccountLink::map_camera(cam.id, acc);
-          if (sim->ent_alive(cam.get_player())) AccountLink::map_player(cam.get_player(), acc);
-        }
+        AccountLink::map_bot(cam.id);
+        if (sim->ent_alive(cam.get_player())) AccountLink::map_bot(cam.get_player());
         if (!sim->ent_alive(cam.get_player())) continue;
         Entity &player = sim->get_ent(cam.get_player());
 
@@ -118,7 +114,7 @@ void on_tick(Simulation *sim) {
         Vector accel(b.out_ax, b.out_ay);
         float mag = accel.magnitude();
         if (mag > PLAYER_ACCELERATION) accel.set_magnitude(PLAYER_ACCELERATION);
-        player.acceleration = accel;
+        player.acceleration() = accel;
         player.input = b.out_flags;
     }
 }
@@ -4,6 +4,7 @@
 #include <Server/PetalTracker.hh>
 #include <Server/Server.hh>
 #include <Server/Spawn.hh>
+#include <Server/Account/AccountLevel.hh>
 #include <Server/Account/AccountLink.hh>
 #ifdef WASM_SERVER
 #include <Server/Account/WasmAccountStore.hh>
@@ -53,6 +54,26 @@ uint8_t Client::alive() {
     && simulation->ent_exists(simulation->get_ent(camera).get_player());
 }
 
+//only touches this client, so update jobs can queue from worker threads
+void Client::queue_packet(uint8_t const *packet, size_t size) {
+    uint8_t prefix[5];
+    Writer w(prefix);
+    w.write<uint32_t>(size);
+    if (outbox.empty()) outbox.push_back(Clientbound::kBatch);
+    outbox.insert(outbox.end(), prefix, w.at);
+    outbox_messages.emplace_back(outbox.size(), size);
+    outbox.insert(outbox.end(), packet, packet + size);
+}
+
+void Client::flush_packets() {
+    if (outbox_messages.size() == 1 || outbox.size() > MAX_PACKET_LEN) {
+        //a lone message goes out unwrapped, and so does everything if the batch is too big for the client's buffer
+        for (auto const &[at, size] : outbox_messages) send_packet(outbox.data() + at, size);
+    } else if (outbox_messages.size() > 1) send_packet(outbox.data(), outbox.size());
+    outbox.clear();
+    outbox_messages.clear();
+}
+
 void Client::on_message(WebSocket *ws, std::string_view message, uint64_t code) {
     if (ws == nullptr) return;
     uint8_t const *data = reinterpret_cast<uint8_t const *>(message.data());
@@ -104,14 +125,14 @@ void Client::on_message(WebSocket *ws, std::string_view message, uint64_t code)
             )) return;
             float x = reader.read<float>();
             float y = reader.read<float>();
-            if (x == 0 && y == 0) player.acceleration.set(0,0);
+            if (x == 0 && y == 0) player.acceleration().set(0,0);
             else {
                 if (std::abs(x) > 5e3 || std::abs(y) > 5e3) break;
                 Vector accel(x,y);
                 float m = accel.magnitude();
                 if (m > 200) accel.set_magnitude(PLAYER_ACCELERATION);
                 else accel.set_magnitude(m / 200 * PLAYER_ACCELERATION);
-                player.acceleration = accel;
+                player.acceleration() = accel;
             }
             player.input = reader.read<uint8_t>();
             break;
@@ -133,6 +154,7 @@ void Client::on_message(WebSocket *ws, std::string_view message, uint64_t code)
                         // Link player entity to account for server-side kill tracking
             if (!client->account_id.empty()) {
                 AccountLink::map_player(player.id, client->account_id);
+                player.account_level = AccountLevel::get_level(client->account_id);
             }
 
             break;
@@ -154,13 +176,10 @@ void Client::on_message(WebSocket *ws, std::string_view message, uint64_t code)
                 player.set_score(player.get_score() + gained);
                 // Also grant Account XP for trashing non-basic petals
 #ifndef WASM_SERVER
-                if (!client->account_id.empty()) {
-                    AuthDB::add_account_xp(client->account_id, (int)gained);
-                    Server::game.send_account_level_to_account(client->account_id);
-                }
+                if (!client->account_id.empty()) AccountLevel::add_xp(client->account_id, gained);
 #else
                 if (!client->account_id.empty()) {
-                    WasmAccountStore::add_xp(client->account_id, gained);
+                    AccountLevel::add_xp(client->account_id, gained);
                     add_account_xp_js(client->account_id.c_str(), (int)gained);
                     Server::game.send_account_level_to_account(client->account_id);
                 }
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <Shared/Binary.hh>
+#include <Shared/Entity.hh>
 #include <Shared/EntityDef.hh>
 
+#include <Helpers/Bits.hh>
+
+#include <array>
 #include <cstdint>
-#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #ifdef WASM_SERVER
 class WebSocket;
@@ -18,11 +23,37 @@ typedef uWS::WebSocket<false, true, PerSocketData> WebSocket;
 
 class GameInstance;
 
+//set of entities keyed by id, with the hash each id was added with
+//an id that shows up with another hash was deleted and reused in between
+class EntityView {
+public:
+    std::array<uint64_t, ENTITY_CAP / 64> bits;
+    std::array<EntityID::hash_type, ENTITY_CAP> hashes;
+    EntityView() { bits.fill(0); }
+    void insert(EntityID const &id) {
+        BitMath::set(bits[id.id / 64], id.id % 64);
+        hashes[id.id] = id.hash;
+    }
+};
+
 class Client {
 public:
     GameInstance *game;
     EntityID camera;
-    std::set<EntityID> in_view;
+    EntityView in_view;
+    //entities this client was sent last tick, so it holds the values deltas are taken against
+    std::array<uint64_t, ENTITY_CAP / 64> synced{};
+    //how overdue each entity in view is for an update, 1 being due
+    std::array<float, ENTITY_CAP> update_priority{};
+    //fields that changed while an entity's updates were held back, sent with its next one
+    std::array<std::array<uint8_t, Entity::CHANGE_BYTES>, ENTITY_CAP> missed_changes{};
+    //this tick's messages, sent as one kBatch frame by flush_packets
+    std::vector<uint8_t> outbox;
+    //offset and size of each message in outbox
+    std::vector<std::pair<uint32_t, uint32_t>> outbox_messages;
+    //account levels and top-account flower the client was last sent, so they only go out on change
+    std::array<uint32_t, ENTITY_CAP> sent_account_levels{};
+    EntityID sent_top_leader;
     WebSocket *ws;
     uint8_t verified = 0;
     uint8_t seen_arena = 0;
@@ -35,6 +66,8 @@ public:
     uint8_t alive();
 
     void send_packet(uint8_t const *, size_t);
+    void queue_packet(uint8_t const *, size_t);
+    void flush_packets();
     bool check_invalid(bool);
     static void on_message(WebSocket *, std::string_view, uint64_t);
     static void on_disconnect(WebSocket *, int, std::string_view);
@@ -0,0 +1,58 @@
+#include <Server/DeltaCache.hh>
+
+#include <Shared/Binary.hh>
+#include <Shared/Entity.hh>
+
+#include <cstring>
+#include <thread>
+
+//comfortably above the largest create, which is bounded by a few fixed-size arrays and two names
+static uint32_t const MAX_ENTITY_BYTES = 4096;
+static uint32_t const BLOCK_SIZE = 64 * 1024;
+
+DeltaCache::DeltaCache() : epoch(1) {
+    for (std::array<Slot, ENTITY_CAP> &encoding : slots)
+        for (Slot &slot : encoding) slot.stamp.store(0, std::memory_order_relaxed);
+}
+
+uint8_t *DeltaCache::_reserve(Arena &arena) {
+    if (arena.block < arena.blocks.size() && arena.used + MAX_ENTITY_BYTES <= BLOCK_SIZE)
+        return arena.blocks[arena.block].get() + arena.used;
+    if (arena.block < arena.blocks.size()) ++arena.block;
+    if (arena.block == arena.blocks.size()) arena.blocks.emplace_back(new uint8_t[BLOCK_SIZE]);
+    arena.used = 0;
+    return arena.blocks[arena.block].get();
+}
+
+void DeltaCache::write(Writer &writer, Entity &ent, uint8_t encoding) {
+    Slot &slot = slots[encoding][ent.id.id];
+    uint32_t const claimed = epoch * 2;
+    uint32_t const ready = epoch * 2 + 1;
+    uint32_t stamp = slot.stamp.load(std::memory_order_acquire);
+    if (stamp != ready) {
+        if (stamp != claimed && slot.stamp.compare_exchange_strong(stamp, claimed, std::memory_order_acquire)) {
+            Arena &arena = arenas[JobSystem::shared().thread_index()];
+            Writer encoder(_reserve(arena));
+            ent.write(&encoder, encoding);
+            slot.data = encoder.packet;
+            slot.size = encoder.at - encoder.packet;
+            DEBUG_ONLY(assert(slot.size <= MAX_ENTITY_BYTES);)
+            arena.used += slot.size;
+            slot.stamp.store(ready, std::memory_order_release);
+        } else {
+            //another thread is encoding it right now
+            while (slot.stamp.load(std::memory_order_acquire) != ready)
+                std::this_thread::yield();
+        }
+    }
+    std::memcpy(writer.at, slot.data, slot.size);
+    writer.at += slot.size;
+}
+
+void DeltaCache::invalidate() {
+    ++epoch;
+    for (Arena &arena : arenas) {
+        arena.block = 0;
+        arena.used = 0;
+    }
+}
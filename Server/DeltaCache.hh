@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Server/JobSystem.hh>
+
+#include <Shared/Entity.hh>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Writer;
+
+//every client that sees an entity in a tick gets the same bytes for it,
+//so each entity is encoded once per tick and copied into each packet
+//safe to call from several threads: the first to claim an entity encodes it into its own arena
+class DeltaCache {
+    struct Slot {
+        //epoch * 2 while being encoded, epoch * 2 + 1 once ready; anything else is stale
+        std::atomic<uint32_t> stamp;
+        uint8_t const *data;
+        uint32_t size;
+    };
+    //fixed-size blocks, so encoded bytes never move while other threads copy them
+    struct Arena {
+        std::vector<std::unique_ptr<uint8_t[]>> blocks;
+        uint32_t block = 0;
+        uint32_t used = 0;
+    };
+    std::array<Arena, JobSystem::MAX_THREADS> arenas;
+    uint32_t epoch;
+    //one slot per entity for each EntityEncoding
+    std::array<std::array<Slot, ENTITY_CAP>, kEncodingCount> slots;
+    uint8_t *_reserve(Arena &);
+public:
+    DeltaCache();
+    //same bytes as ent.write(&writer, encoding)
+    void write(Writer &, Entity &, uint8_t);
+    //entity state changes after this, called from post_tick
+    void invalidate();
+};
@@ -11,6 +11,7 @@ void inflict_heal(Simulation *, Entity &, float);
 
 void entity_on_death(Simulation *, Entity const &);
 
+void acquire_nearest_enemy(Simulation *, Entity &);
 EntityID find_nearest_enemy(Simulation *, Entity const &, float);
 
 void entity_set_despawn_tick(Entity &, game_tick_t);
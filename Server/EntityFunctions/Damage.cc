@@ -63,8 +63,8 @@ void inflict_damage(Simulation *sim, EntityID const atk_id, EntityID const def_i
     
     if (!sim->ent_alive(atk_id)) return;
 
-    if (defender.slow_ticks < attacker.slow_inflict)
-        defender.slow_ticks = attacker.slow_inflict;
+    if (defender.slow_ticks() < attacker.slow_inflict)
+        defender.slow_ticks() = attacker.slow_inflict;
     
     if (attacker.has_component(kPetal)) {
         switch (attacker.get_petal_id()) {
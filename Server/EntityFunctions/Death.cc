@@ -3,10 +3,11 @@
 #include <Server/PetalTracker.hh>
 #include <Server/Spawn.hh>
 #ifndef WASM_SERVER
-#include <Server/AuthDB.hh>
+#include <Server/Account/AccountCache.hh>
 #else
 #include <Server/Account/WasmAccountStore.hh>
 #endif
+#include <Server/Account/AccountLevel.hh>
 #include <Server/Account/AccountLink.hh>
 #include <Server/Server.hh>
 
@@ -42,7 +43,7 @@ static void _alloc_drops(Simulation *sim, std::vector<PetalID::T> &success_drops
             Entity &drop = alloc_drop(sim, success_drops[i]);
             drop.set_x(x);
             drop.set_y(y);
-            drop.velocity.unit_normal(i * 2 * M_PI / count).set_magnitude(25);
+            drop.velocity().unit_normal(i * 2 * M_PI / count).set_magnitude(25);
         }
     } else if (count == 1) {
         Entity &drop = alloc_drop(sim, success_drops[0]);
@@ -60,7 +61,7 @@ static void _add_score(Simulation *sim, EntityID const killer_id, Entity const &
 
 void entity_on_death(Simulation *sim, Entity const &ent) {
     // don't do on_death for any despawned entity
-    uint8_t natural_despawn = BitMath::at(ent.flags, EntityFlags::kIsDespawning) && ent.despawn_tick == 0;
+    uint8_t natural_despawn = BitMath::at(ent.flags(), EntityFlags::kIsDespawning) && ent.despawn_tick == 0;
     if (ent.score_reward > 0 && sim->ent_exists(ent.last_damaged_by) && !natural_despawn) {
         EntityID killer_id = sim->get_ent(ent.last_damaged_by).base_entity;
         _add_score(sim, killer_id, ent);
@@ -70,24 +71,23 @@ void entity_on_death(Simulation *sim, Entity const &ent) {
             for (uint8_t i = 0; i < ent.damager_count; ++i) {
                 EntityID damager = ent.damagers[i];
                 if (sim->ent_alive(damager)) {
-                    std::string acc = AccountLink::get_account_for_entity(damager);
+                    std::string const &acc = AccountLink::get_account_for_entity(damager);
                     if (!acc.empty()) {
 #ifndef WASM_SERVER
-                        AuthDB::record_mob_kill(acc, (int)ent.get_mob_id());
+                        AccountCache::record_mob_kill(acc, ent.get_mob_id());
                         // Grant account XP equal to in-game XP earned from this mob
-                        AuthDB::add_account_xp(acc, (int)ent.score_reward);
-                        // Push updated account level/xp to this account so client bar updates live
-                        Server::game.send_account_level_to_account(acc);
+                        // The cache marks the gallery and level dirty, and both go out with the next update
+                        AccountLevel::add_xp(acc, ent.score_reward);
 #else
                         // Update in-memory gallery and XP, and persist via JS bridge
                         WasmAccountStore::set_bit(WasmAccountStore::Category::MobGallery, acc, (int)ent.get_mob_id());
-                        WasmAccountStore::add_xp(acc, (uint32_t)ent.score_reward);
+                        AccountLevel::add_xp(acc, ent.score_reward);
                         record_mob_kill_js(acc.c_str(), (int)ent.get_mob_id());
                         add_account_xp_js(acc.c_str(), (int)ent.score_reward);
                         // Push updated account level/xp to this account so client bar updates live
                         Server::game.send_account_level_to_account(acc);
-#endif
                         Server::game.send_mob_gallery_to_account(acc);
+#endif
                     }
                 }
             }
@@ -116,9 +116,9 @@ void entity_on_death(Simulation *sim, Entity const &ent) {
     }
 
     if (ent.has_component(kMob)) {
-        if (BitMath::at(ent.flags, EntityFlags::kSpawnedFromZone))
+        if (BitMath::at(ent.flags(), EntityFlags::kSpawnedFromZone))
             Map::remove_mob(sim, ent.zone);
-        if (!natural_despawn && !(BitMath::at(ent.flags, EntityFlags::kNoDrops))) {
+        if (!natural_despawn && !(BitMath::at(ent.flags(), EntityFlags::kNoDrops))) {
             struct MobData const &mob_data = MOB_DATA[ent.get_mob_id()];
             std::vector<PetalID::T> success_drops = {};
                         // drop_rates are stored as percentages. Apply global multiplier and floor at runtime.
@@ -215,7 +215,7 @@ void entity_on_death(Simulation *sim, Entity const &ent) {
         }
 
     } else if (ent.has_component(kDrop)) {
-        if (BitMath::at(ent.flags, EntityFlags::kIsDespawning))
+        if (BitMath::at(ent.flags(), EntityFlags::kIsDespawning))
             PetalTracker::remove_petal(sim, ent.get_drop_id());
     }
 }
@@ -3,9 +3,12 @@
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 
-EntityID find_nearest_enemy(Simulation *simulation, Entity const &entity, float radius) {
-    if ((entity.id.id - entity.lifetime) % (TPS / 5) != 0) return NULL_ENTITY;
-    if (entity.immunity_ticks > 0) return NULL_ENTITY;
+static uint8_t _can_acquire(Entity const &entity) {
+    if ((entity.id.id - entity.lifetime) % (TPS / 5) != 0) return 0;
+    return entity.immunity_ticks == 0;
+}
+
+static EntityID _query_nearest_enemy(Simulation *simulation, Entity const &entity, float radius, float &dist_out) {
     EntityID ret;
     float min_dist = radius;
     simulation->spatial_hash.query(entity.get_x(), entity.get_y(), radius, radius, [&](Simulation *sim, Entity &ent){
@@ -21,5 +24,31 @@ EntityID find_nearest_enemy(Simulation *simulation, Entity const &entity, float
         float dist = Vector(ent.get_x()-entity.get_x(),ent.get_y()-entity.get_y()).magnitude();
         if (dist < min_dist) { min_dist = dist; ret = ent.id; }
     });
+    dist_out = min_dist;
     return ret;
-}
\ No newline at end of file
+}
+
+//run for every mob on the job system before the ai pass; reads positions and the grid and
+//writes only the mob's own nearest_enemy, over the widest radius any ai looks in
+void acquire_nearest_enemy(Simulation *sim, Entity &entity) {
+    entity.nearest_enemy = NULL_ENTITY;
+    //negative when there's nothing to reuse, so find_nearest_enemy queries itself
+    entity.nearest_enemy_dist = -1;
+    if (!_can_acquire(entity)) return;
+    if (BitMath::at(entity.flags(), EntityFlags::kIsCulled)) return;
+    if (sim->ent_alive(entity.seg_head)) return;
+    entity.nearest_enemy = _query_nearest_enemy(sim, entity, entity.detection_radius + entity.get_radius(), entity.nearest_enemy_dist);
+}
+
+//the ai pass only removes candidates (deletes) and moves nothing, so a nearest enemy that's
+//still alive is still the nearest; if it died since, look again
+EntityID find_nearest_enemy(Simulation *simulation, Entity const &entity, float radius) {
+    if (!_can_acquire(entity)) return NULL_ENTITY;
+    if (entity.nearest_enemy_dist >= 0 && radius <= entity.detection_radius + entity.get_radius()) {
+        if (entity.nearest_enemy.null()) return NULL_ENTITY;
+        if (simulation->ent_alive(entity.nearest_enemy))
+            return entity.nearest_enemy_dist < radius ? entity.nearest_enemy : NULL_ENTITY;
+    }
+    float dist;
+    return _query_nearest_enemy(simulation, entity, radius, dist);
+}
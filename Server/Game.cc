@@ -1,6 +1,7 @@
 #include <Server/Game.hh>
 
 #include <Server/Client.hh>
+#include <Server/JobSystem.hh>
 #include <Server/PetalTracker.hh>
 #include <Server/Server.hh>
 #include <Server/Spawn.hh>
@@ -8,7 +9,7 @@
 #include <Server/Bots/ForwardShims.hh>
 #include <Server/Account/AccountLevel.hh>
 #ifndef WASM_SERVER
-#include <Server/AuthDB.hh>
+#include <Server/Account/AccountCache.hh>
 #else
 #include <Server/Account/WasmAccountStore.hh>
 #endif
@@ -33,14 +34,8 @@ static void _send_mob_gallery_for(Client *client) {
     uint32_t bytes = (N + 7) / 8;
     std::vector<uint8_t> bits(bytes, 0);
 #ifndef WASM_SERVER
-    {
-        std::vector<int> mob_ids;
-        if (AuthDB::get_mob_ids(client->account_id, mob_ids)) {
-            for (int id : mob_ids) {
-                if (id >= 0 && id < (int)N) bits[(uint32_t)id >> 3] |= (1u << ((uint32_t)id & 7));
-            }
-        }
-    }
+    if (AccountCache::Account const *acc = AccountCache::get(client->account_id))
+        std::copy(acc->mob_gallery.begin(), acc->mob_gallery.end(), bits.begin());
 #else
         {
         std::vector<uint8_t> cached;
@@ -57,18 +52,24 @@ static void _send_mob_gallery_for(Client *client) {
 
     w.write<uint32_t>(bytes);
     for (uint32_t i=0;i<bytes;++i) w.write<uint8_t>(bits[i]);
-    client->send_packet(w.packet, w.at - w.packet);
+    client->queue_packet(w.packet, w.at - w.packet);
 }
 
 static void _send_account_level_for(Client *client) {
     if (!client || client->account_id.empty()) return;
     uint32_t lvl = 1, xp = 0;
     AccountLevel::get_level_and_xp(client->account_id, lvl, xp);
+    //this goes out whenever the account's xp changes, so keep the level over its flower in step
+    Simulation *sim = &client->game->simulation;
+    if (sim->ent_exists(client->camera)) {
+        EntityID const player = sim->get_ent(client->camera).get_player();
+        if (sim->ent_exists(player)) sim->get_ent(player).account_level = lvl;
+    }
     Writer w(Server::OUTGOING_PACKET);
     w.write<uint8_t>(Clientbound::kAccountLevel);
     w.write<uint32_t>(lvl);
     w.write<uint32_t>(xp);
-    client->send_packet(w.packet, w.at - w.packet);
+    client->queue_packet(w.packet, w.at - w.packet);
 
     // Also send explicit xp requirement for next level
     uint32_t need = AccountLevel::get_xp_needed_for_next(lvl);
@@ -77,7 +78,7 @@ static void _send_account_level_for(Client *client) {
     w2.write<uint32_t>(lvl);
     w2.write<uint32_t>(xp);
     w2.write<uint32_t>(need);
-    client->send_packet(w2.packet, w2.at - w2.packet);
+    client->queue_packet(w2.packet, w2.at - w2.packet);
 }
 
 static void _send_petal_gallery_for(Client *client) {
@@ -89,14 +90,8 @@ static void _send_petal_gallery_for(Client *client) {
     uint32_t bytes = (N + 7) / 8;
     std::vector<uint8_t> bits(bytes, 0);
 #ifndef WASM_SERVER
-    {
-        std::vector<int> petal_ids;
-        if (AuthDB::get_petal_ids(client->account_id, petal_ids)) {
-            for (int id : petal_ids) {
-                if (id >= 0 && id < (int)N) bits[(uint32_t)id >> 3] |= (1u << ((uint32_t)id & 7));
-            }
-        }
-    }
+    if (AccountCache::Account const *acc = AccountCache::get(client->account_id))
+        std::copy(acc->petal_gallery.begin(), acc->petal_gallery.end(), bits.begin());
 #else
         {
         std::vector<uint8_t> cached;
@@ -115,22 +110,62 @@ static void _send_petal_gallery_for(Client *client) {
 
     w.write<uint32_t>(bytes);
     for (uint32_t i=0;i<bytes;++i) w.write<uint8_t>(bits[i]);
-    client->send_packet(w.packet, w.at - w.packet);
+    client->queue_packet(w.packet, w.at - w.packet);
 } 
  
 
-static void _update_client(Simulation *sim, Client *client) {
-    if (client == nullptr) return;
-    if (!client->verified) return;
-    if (sim == nullptr) return;
-    if (!sim->ent_exists(client->camera)) return;
-    std::set<EntityID> in_view;
-    std::vector<EntityID> deletes;
+static uint8_t _can_update(Simulation *sim, Client *client) {
+    if (client == nullptr) return 0;
+    if (!client->verified) return 0;
+    if (sim == nullptr) return 0;
+    return sim->ent_exists(client->camera);
+}
+
+//entities that update every tick no matter how busy the view is
+static uint8_t _always_update(Entity const &camera, Entity const &ent) {
+    if (ent.id == camera.id || ent.id == camera.get_player()) return 1;
+    if (!ent.has_component(kPhysics)) return 1;
+    if (ent.has_component(kHealth) && ent.get_damaged()) return 1;
+    //the player's own petals
+    return ent.has_component(kRelations) && ent.get_parent() == camera.get_player();
+}
+
+//share of ticks an entity gets an update: every tick in the middle of the view, down to a quarter
+//at its edges, and an eighth when nothing about it changed
+static float _update_weight(Entity const &camera, Entity const &ent) {
+    if (!ent.has_changes()) return 0.125;
+    float const dx = std::fabs(ent.get_x() - camera.get_camera_x()) * camera.get_fov() / 960;
+    float const dy = std::fabs(ent.get_y() - camera.get_camera_y()) * camera.get_fov() / 540;
+    return lerp(1, 0.25, fclamp(std::max(dx, dy) * 2 - 1, 0, 1));
+}
+
+static void _write_entity(Simulation *sim, Client *client, Writer &writer, Entity &ent, EntityID const &id, uint8_t create) {
+    writer.write<EntityID>(id);
+    writer.write<uint8_t>(create | (ent.pending_delete << 1));
+    std::array<uint8_t, Entity::CHANGE_BYTES> &missed = client->missed_changes[id.id];
+    uint8_t held_back = 0;
+    for (uint8_t m : missed) held_back |= m;
+    //deltas are against the previous tick's values, which the client only has if it got that update
+    if (create) sim->delta_cache.write(writer, ent, kEncodeCreate);
+    else if (BitMath::at(client->synced[id.id / 64], id.id % 64)) sim->delta_cache.write(writer, ent, kEncodeDelta);
+    else if (!held_back) sim->delta_cache.write(writer, ent, kEncodeUpdate);
+    else ent.write(&writer, kEncodeUpdate, missed.data());
+    missed.fill(0);
+    client->update_priority[id.id] = 0;
+}
+
+//runs on the job system, one client per job: only reads the simulation and writes to the client
+static void _build_client_update(Simulation *sim, Client *client, uint8_t *buffer) {
+    if (!_can_update(sim, client)) {
+        client->synced.fill(0);
+        return;
+    }
+    EntityView in_view;
     in_view.insert(client->camera);
     Entity &camera = sim->get_ent(client->camera);
     if (sim->ent_exists(camera.get_player())) 
         in_view.insert(camera.get_player());
-    Writer writer(Server::OUTGOING_PACKET);
+    Writer writer(buffer);
     writer.write<uint8_t>(Clientbound::kClientUpdate);
     writer.write<EntityID>(client->camera);
         sim->spatial_hash.query(camera.get_camera_x(), camera.get_camera_y(), 
@@ -141,7 +176,7 @@ static void _update_client(Simulation *sim, Client *client) {
     sim->for_each<kCamera>([&](Simulation *sm, Entity &other_cam){
         if (other_cam.id == camera.id) return;
         // Only replicate bot cameras
-        if (!BitMath::at(other_cam.flags, EntityFlags::kCPUControlled)) return;
+        if (!BitMath::at(other_cam.flags(), EntityFlags::kCPUControlled)) return;
         float dx = std::fabs(other_cam.get_camera_x() - camera.get_camera_x());
         float dy = std::fabs(other_cam.get_camera_y() - camera.get_camera_y());
         if (dx <= 960 / camera.get_fov() + 50 && dy <= 540 / camera.get_fov() + 50) {
@@ -150,76 +185,116 @@ static void _update_client(Simulation *sim, Client *client) {
     });
 
 
-    for (EntityID const &i: client->in_view) {
-        if (!in_view.contains(i)) {
-            writer.write<EntityID>(i);
-            deletes.push_back(i);
+    //diff against what the client has word by word; ids whose hash changed leave and enter again
+    EntityView &seen = client->in_view;
+    std::array<uint64_t, ENTITY_CAP / 64> enter;
+    for (uint32_t w = 0; w < ENTITY_CAP / 64; ++w) {
+        uint64_t reused = 0;
+        for (uint64_t both = seen.bits[w] & in_view.bits[w]; both; both &= both - 1) {
+            uint32_t const bit = BitMath::lowest(both);
+            if (seen.hashes[w * 64 + bit] != in_view.hashes[w * 64 + bit]) reused |= 1ull << bit;
+        }
+        uint64_t const changed = seen.bits[w] ^ in_view.bits[w];
+        for (uint64_t leave = (changed & seen.bits[w]) | reused; leave; leave &= leave - 1) {
+            EntityID::id_type const id = w * 64 + BitMath::lowest(leave);
+            writer.write<EntityID>(EntityID(id, seen.hashes[id]));
+            //the client forgets the level of anything that leaves its view
+            client->sent_account_levels[id] = 0;
         }
+        enter[w] = (changed & in_view.bits[w]) | reused;
     }
-
-    for (EntityID const &i : deletes)
-        client->in_view.erase(i);
-
     writer.write<EntityID>(NULL_ENTITY);
-    //upcreates
-    for (EntityID id: in_view) {
-        DEBUG_ONLY(assert(sim->ent_exists(id));)
+    //upcreates: creates, deletions and what needs to look live go out in id order; the rest build up
+    //priority and, once due, go out most overdue first while the byte budget lasts
+    static thread_local std::vector<std::pair<float, EntityID>> due;
+    due.clear();
+    std::array<uint64_t, ENTITY_CAP / 64> sent{};
+    for (uint32_t w = 0; w < ENTITY_CAP / 64; ++w) {
+        for (uint64_t bits = in_view.bits[w]; bits; bits &= bits - 1) {
+            uint32_t const bit = BitMath::lowest(bits);
+            EntityID const id(w * 64 + bit, in_view.hashes[w * 64 + bit]);
+            DEBUG_ONLY(assert(sim->ent_exists(id));)
+            Entity &ent = sim->get_ent(id);
+            uint8_t create = BitMath::at(enter[w], bit);
+            if (create) seen.hashes[id.id] = id.hash;
+            if (create || ent.pending_delete || _always_update(camera, ent)) {
+                _write_entity(sim, client, writer, ent, id, create);
+                BitMath::set(sent[w], bit);
+                continue;
+            }
+            float &priority = client->update_priority[id.id];
+            priority += _update_weight(camera, ent);
+            if (priority >= 1) due.emplace_back(priority, id);
+            else ent.merge_changes(client->missed_changes[id.id].data());
+        }
+        seen.bits[w] = in_view.bits[w];
+    }
+    std::sort(due.begin(), due.end(), [](std::pair<float, EntityID> const &a, std::pair<float, EntityID> const &b) {
+        return a.first != b.first ? a.first > b.first : a.second.id < b.second.id;
+    });
+    uint8_t const *budget_start = writer.at;
+    for (auto const &[priority, id] : due) {
         Entity &ent = sim->get_ent(id);
-        uint8_t create = !client->in_view.contains(id);
-        writer.write<EntityID>(id);
-        writer.write<uint8_t>(create | (ent.pending_delete << 1));
-        ent.write(&writer, BitMath::at(create, 0));
-        client->in_view.insert(id);
+        if (size_t(writer.at - budget_start) >= UPDATE_BYTE_BUDGET) {
+            ent.merge_changes(client->missed_changes[id.id].data());
+            continue;
+        }
+        _write_entity(sim, client, writer, ent, id, 0);
+        BitMath::set(sent[id.id / 64], id.id % 64);
     }
+    client->synced = sent;
     writer.write<EntityID>(NULL_ENTITY);
     //write arena stuff
     writer.write<uint8_t>(client->seen_arena);
     sim->arena_info.write(&writer, client->seen_arena);
     client->seen_arena = 1;
-    client->send_packet(writer.packet, writer.at - writer.packet);
+    client->queue_packet(writer.packet, writer.at - writer.packet);
+}
 
-    // After the main update, send real account levels for visible real players (not bots)
-    {
-        Writer w(Server::OUTGOING_PACKET);
-        w.write<uint8_t>(Clientbound::kEntityAccountLevels);
-        for (EntityID const &id : in_view) {
+
+//only flowers that just came into view or whose level changed, and the top account's flower when it changes
+static void _send_account_info(Simulation *sim, Client *client, EntityID const &top_player_ent) {
+    EntityView const &in_view = client->in_view;
+    Writer w(Server::OUTGOING_PACKET);
+    w.write<uint8_t>(Clientbound::kEntityAccountLevels);
+    uint8_t const *start = w.at;
+    for (uint32_t word = 0; word < ENTITY_CAP / 64; ++word) {
+        for (uint64_t bits = in_view.bits[word]; bits; bits &= bits - 1) {
+            EntityID::id_type const i = word * 64 + BitMath::lowest(bits);
+            EntityID const id(i, in_view.hashes[i]);
             if (!sim->ent_exists(id)) continue;
             Entity &e = sim->get_ent(id);
-            if (!e.has_component(kFlower)) continue;
-            // Resolve account for this entity; bots are mapped to "bot:*" and should be skipped
-            std::string acc = AccountLink::get_account_for_entity(e.id);
-            if (acc.empty()) continue;
-            if (acc.rfind("bot:", 0) == 0) continue; // starts with "bot:"
-            uint32_t lvl = 1, xp = 0;
-            AccountLevel::get_level_and_xp(acc, lvl, xp);
+            //bots and guests have no account and stay at 0
+            if (!e.has_component(kFlower) || e.account_level == 0) continue;
+            if (client->sent_account_levels[i] == e.account_level) continue;
+            client->sent_account_levels[i] = e.account_level;
             w.write<EntityID>(e.id);
-            w.write<uint32_t>(lvl);
+            w.write<uint32_t>(e.account_level);
         }
-        // terminator
+    }
+    if (w.at != start) {
         w.write<EntityID>(NULL_ENTITY);
-        client->send_packet(w.packet, w.at - w.packet);
+        client->queue_packet(w.packet, w.at - w.packet);
     }
-        {
-        // Determine the global top account by total XP (offline or online)
-        std::string top_acc;
-#ifndef WASM_SERVER
-        AuthDB::get_top_account_by_xp(top_acc);
-#else
-        WasmAccountStore::get_top_account(top_acc);
-#endif
-        EntityID top_player_ent = NULL_ENTITY;
-        if (!top_acc.empty()) {
-            // Find if this top account has a currently online player entity to anchor the crown.
-            sim->for_each<kFlower>([&](Simulation *sm, Entity &pl){
-                std::string acc = AccountLink::get_account_for_entity(pl.id);
-                if (acc == top_acc) { top_player_ent = pl.id; }
-            });
-        }
+    if (!(client->sent_top_leader == top_player_ent)) {
         Writer w(Server::OUTGOING_PACKET);
         w.write<uint8_t>(Clientbound::kTopAccountLeader);
         w.write<EntityID>(top_player_ent);
-        client->send_packet(w.packet, w.at - w.packet);
+        client->queue_packet(w.packet, w.at - w.packet);
+        client->sent_top_leader = top_player_ent;
+    }
+}
+
+//the flower of the top account by xp, if it's online
+static EntityID _top_account_player(Simulation *sim, std::set<Client *> const &clients) {
+    std::string const &top_acc = AccountLevel::get_top_account();
+    if (top_acc.empty()) return NULL_ENTITY;
+    for (Client *client : clients) {
+        if (client->account_id != top_acc || !sim->ent_exists(client->camera)) continue;
+        EntityID const player = sim->get_ent(client->camera).get_player();
+        if (sim->ent_exists(player)) return player;
     }
+    return NULL_ENTITY;
 }
 
 GameInstance::GameInstance() : simulation(), clients(), team_manager(&simulation) {}
@@ -241,11 +316,41 @@ void GameInstance::tick() {
     // IMPORTANT: Drive bot AI before simulation.tick so their inputs apply this frame
     Bots_on_tick(&simulation);
     simulation.tick();
-    for (Client *client : clients)
-        _update_client(&simulation, client);
+    _update_clients();
     simulation.post_tick();
 }
 
+void GameInstance::_update_clients() {
+    //packets are built in parallel, each worker writing into its own buffer,
+    //then sent from this thread in client order since sockets belong to the event loop
+    JobSystem &jobs = JobSystem::shared();
+    static std::vector<std::vector<uint8_t>> buffers;
+    if (buffers.size() < jobs.size()) buffers.resize(jobs.size(), std::vector<uint8_t>(MAX_PACKET_LEN));
+    std::vector<Client *> targets(clients.begin(), clients.end());
+    simulation.spatial_hash.flush();
+    jobs.parallel_for(targets.size(), [&](uint32_t i) {
+        _build_client_update(&simulation, targets[i], buffers[jobs.thread_index()].data());
+    });
+    EntityID const top_player_ent = _top_account_player(&simulation, clients);
+    for (Client *client : targets) {
+        #ifndef WASM_SERVER
+        //galleries and levels go out when the account changed this tick, however many kills did it
+        if (AccountCache::Account const *acc = AccountCache::get(client->account_id)) {
+            if (acc->dirty & AccountCache::kMobGallery) _send_mob_gallery_for(client);
+            if (acc->dirty & AccountCache::kPetalGallery) _send_petal_gallery_for(client);
+            if (acc->dirty & AccountCache::kLevel) _send_account_level_for(client);
+        }
+        #endif
+        if (_can_update(&simulation, client))
+            _send_account_info(&simulation, client, top_player_ent);
+        //everything queued this tick, galleries and levels from kills included, goes out as one frame
+        client->flush_packets();
+    }
+    #ifndef WASM_SERVER
+    AccountCache::flush();
+    #endif
+}
+
 void GameInstance::add_client(Client *client) {
     DEBUG_ONLY(assert(client->game != this);)
     if (client->game != nullptr)
@@ -276,6 +381,9 @@ void GameInstance::add_client(Client *client) {
 
         if (!client->account_id.empty()) {
         AccountLink::map_camera(client->camera, client->account_id);
+        #ifndef WASM_SERVER
+        AccountCache::load(client->account_id);
+        #endif
         _send_mob_gallery_for(client);
         _send_petal_gallery_for(client);
         _send_account_level_for(client);
@@ -297,6 +405,9 @@ void GameInstance::remove_client(Client *client) {
         AccountLink::unmap_camera(client->camera);
         simulation.request_delete(client->camera);
     }
+    #ifndef WASM_SERVER
+    if (!client->account_id.empty()) AccountCache::release(client->account_id);
+    #endif
     client->game = nullptr;
 }
 
@@ -12,6 +12,7 @@ class Client;
 class GameInstance {
     std::set<Client *> clients;
     TeamManager team_manager;
+    void _update_clients();
 public:
     Simulation simulation;
     GameInstance();
@@ -0,0 +1,128 @@
+#include <Server/JobSystem.hh>
+
+#include <algorithm>
+#include <cstdlib>
+
+static thread_local uint32_t worker_index = UINT32_MAX;
+
+JobSystem::Group::Group() : pending(0) {}
+
+JobSystem::JobSystem(uint32_t count) : queued(0), stopping(0) {
+    for (uint32_t i = 0; i <= count; ++i)
+        queues.emplace_back(std::make_unique<Queue>());
+    for (uint32_t i = 0; i < count; ++i)
+        workers.emplace_back(&JobSystem::_worker, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lk(sleep_mutex);
+        stopping = 1;
+    }
+    sleep.notify_all();
+    for (std::thread &t : workers) t.join();
+}
+
+uint32_t JobSystem::size() const {
+    return workers.size() + 1;
+}
+
+uint32_t JobSystem::thread_index() const {
+    return _own_queue();
+}
+
+uint32_t JobSystem::_own_queue() const {
+    return worker_index < workers.size() ? worker_index : workers.size();
+}
+
+bool JobSystem::_pop(uint32_t index, Job &job) {
+    Queue &q = *queues[index];
+    std::lock_guard<std::mutex> lk(q.mutex);
+    if (q.jobs.empty()) return false;
+    job = std::move(q.jobs.back());
+    q.jobs.pop_back();
+    --queued;
+    return true;
+}
+
+bool JobSystem::_steal(uint32_t index, Job &job) {
+    for (uint32_t n = 1; n < queues.size(); ++n) {
+        Queue &q = *queues[(index + n) % queues.size()];
+        std::lock_guard<std::mutex> lk(q.mutex);
+        if (q.jobs.empty()) continue;
+        job = std::move(q.jobs.front());
+        q.jobs.pop_front();
+        --queued;
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::_run_one(uint32_t index) {
+    Job job;
+    if (!_pop(index, job) && !_steal(index, job)) return false;
+    job.fn();
+    job.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobSystem::_worker(uint32_t index) {
+    worker_index = index;
+    while (1) {
+        if (_run_one(index)) continue;
+        std::unique_lock<std::mutex> lk(sleep_mutex);
+        sleep.wait(lk, [&]{ return stopping || queued.load() > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::run(Group &group, std::function<void()> fn) {
+    if (workers.empty()) {
+        fn();
+        return;
+    }
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        Queue &q = *queues[_own_queue()];
+        std::lock_guard<std::mutex> lk(q.mutex);
+        q.jobs.push_back({ std::move(fn), &group });
+        ++queued;
+    }
+    //taking the lock orders this against a worker about to sleep
+    { std::lock_guard<std::mutex> lk(sleep_mutex); }
+    sleep.notify_one();
+}
+
+void JobSystem::wait(Group &group) {
+    uint32_t const index = _own_queue();
+    while (group.pending.load(std::memory_order_acquire) > 0)
+        if (!_run_one(index)) std::this_thread::yield();
+}
+
+void JobSystem::parallel_for(uint32_t count, std::function<void(uint32_t)> const &fn) {
+    if (workers.empty() || count <= 1) {
+        for (uint32_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    Group group;
+    for (uint32_t i = 0; i < count; ++i)
+        run(group, [&fn, i]{ fn(i); });
+    wait(group);
+}
+
+static uint32_t _worker_count() {
+    #if defined(WASM_SERVER) || defined(SINGLE_THREAD_TICK)
+    return 0;
+    #else
+    if (char const *env = std::getenv("SPETALS_WORKER_THREADS"))
+        return std::min<uint32_t>(std::strtoul(env, nullptr, 10), JobSystem::MAX_THREADS - 1);
+    uint32_t hw = std::thread::hardware_concurrency();
+    if (hw <= 1) return 0;
+    return hw - 1 < 7 ? hw - 1 : 7;
+    #endif
+}
+
+JobSystem &JobSystem::shared() {
+    static JobSystem jobs(_worker_count());
+    return jobs;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//work-stealing job system for the parallel parts of a tick
+//every thread owns a deque: it pushes and pops at the back, idle threads steal from the front
+//threads waiting on a group keep running jobs, so jobs may submit and wait on jobs themselves
+//without workers every job runs inline as it is submitted, which is the deterministic debug mode
+class JobSystem {
+public:
+    //upper bound on size(), for per-thread storage
+    static uint32_t const MAX_THREADS = 64;
+    class Group {
+        friend class JobSystem;
+        std::atomic<uint32_t> pending;
+    public:
+        Group();
+    };
+private:
+    struct Job {
+        std::function<void()> fn;
+        Group *group;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+    std::vector<std::thread> workers;
+    //one per worker, plus a shared one for threads outside the pool
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<uint32_t> queued;
+    std::mutex sleep_mutex;
+    std::condition_variable sleep;
+    uint8_t stopping;
+    uint32_t _own_queue() const;
+    bool _pop(uint32_t, Job &);
+    bool _steal(uint32_t, Job &);
+    bool _run_one(uint32_t);
+    void _worker(uint32_t);
+public:
+    JobSystem(uint32_t);
+    ~JobSystem();
+    //threads that can run jobs, including the caller
+    uint32_t size() const;
+    //index of the calling thread, below size(); threads outside the pool share the last one
+    uint32_t thread_index() const;
+    void run(Group &, std::function<void()>);
+    //returns once every job in the group has finished, running jobs in the meantime
+    void wait(Group &);
+    //runs fn(0) .. fn(count - 1) and waits for all of them; completion order is unspecified
+    void parallel_for(uint32_t, std::function<void(uint32_t)> const &);
+    //sized from SPETALS_WORKER_THREADS, or the hardware otherwise
+    //WASM and SINGLE_THREAD_TICK builds get no workers
+    static JobSystem &shared();
+};
@@ -0,0 +1,44 @@
+#include <Server/Leaderboard.hh>
+
+#include <Shared/Entity.hh>
+
+Leaderboard::Leaderboard() {
+    clear();
+}
+
+void Leaderboard::clear() {
+    ranked.clear();
+    tracked.fill(0);
+    next_seq = 0;
+    changed = 1;
+}
+
+uint8_t Leaderboard::contains(EntityID const &id) const {
+    return BitMath::at(tracked[id.id / 64], id.id % 64) && entries[id.id].id == id;
+}
+
+void Leaderboard::update(Entity const &ent) {
+    EntityID::id_type const i = ent.id.id;
+    uint32_t const score = ent.get_score();
+    if (BitMath::at(tracked[i / 64], i % 64)) {
+        Entry &entry = entries[i];
+        if (entry.id == ent.id && entry.score == score) return;
+        ranked.erase(entry);
+        //same flower keeps its place among ties, a reused id starts over
+        if (!(entry.id == ent.id)) entry.seq = next_seq++;
+        entry.score = score;
+        entry.id = ent.id;
+    } else {
+        entries[i] = { score, next_seq++, ent.id };
+        BitMath::set(tracked[i / 64], i % 64);
+    }
+    ranked.insert(entries[i]);
+    changed = 1;
+}
+
+void Leaderboard::remove(EntityID const &id) {
+    if (!contains(id)) return;
+    ranked.erase(entries[id.id]);
+    BitMath::unset(tracked[id.id / 64], id.id % 64);
+    changed = 1;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Shared/EntityDef.hh>
+
+#include <Helpers/Bits.hh>
+
+#include <array>
+#include <cstdint>
+#include <set>
+
+class Entity;
+
+//flowers ordered by score, re-keyed when a score changes instead of sorted every tick
+class Leaderboard {
+    struct Entry {
+        uint32_t score;
+        //order flowers joined in, so ties keep the earlier one ahead
+        uint32_t seq;
+        EntityID id;
+        bool operator<(Entry const &o) const {
+            if (score != o.score) return score > o.score;
+            return seq < o.seq;
+        }
+    };
+    std::set<Entry> ranked;
+    std::array<Entry, ENTITY_CAP> entries;
+    std::array<uint64_t, ENTITY_CAP / 64> tracked;
+    uint32_t next_seq;
+public:
+    //set whenever the ranking or a ranked flower changed, cleared once the arena is refreshed
+    uint8_t changed;
+    Leaderboard();
+    void clear();
+    uint8_t contains(EntityID const &) const;
+    //adds the flower, or moves it to its new score
+    void update(Entity const &);
+    void remove(EntityID const &);
+    //drops every flower cb returns true for
+    template <typename Callback>
+    void remove_if(Callback &&cb) {
+        for (auto it = ranked.begin(); it != ranked.end();) {
+            if (!cb(it->id)) { ++it; continue; }
+            BitMath::unset(tracked[it->id.id / 64], it->id.id % 64);
+            it = ranked.erase(it);
+            changed = 1;
+        }
+    }
+    uint32_t size() const { return ranked.size(); }
+    //highest scores first, at most count of them
+    template <typename Callback>
+    void for_each_top(uint32_t count, Callback &&cb) const {
+        for (auto it = ranked.begin(); it != ranked.end() && count > 0; ++it, --count) cb(it->id);
+    }
+};
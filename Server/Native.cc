@@ -2,11 +2,14 @@
 #include <Server/Server.hh>
 
 #include <Server/Client.hh>
+#include <Server/Account/AccountCache.hh>
 #include <Server/AuthDB.hh>
 #include <Server/PerSocketData.hh>
 #include <Shared/Config.hh>
 
 #include <App.h>
+#include <csignal>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <vector>
@@ -45,7 +48,12 @@ uWS::App Server::server = uWS::App({
     .passphrase = "1234"
 }).ws<PerSocketData>("/*", {
     /* Settings */
+#ifdef COMPRESS_UPDATES
+    //a window per socket: consecutive updates repeat most of their bytes (see update-compression-bench)
+    .compression = uWS::DEDICATED_COMPRESSOR,
+#else
     .compression = uWS::DISABLED,
+#endif
     .maxPayloadLength = 1024,
     .idleTimeout = 15,
     .maxBackpressure = 1024 * MAX_PACKET_LEN,
@@ -130,17 +138,39 @@ uWS::App Server::server = uWS::App({
     }
 });
 
+//set from the signal handler, acted on from the loop where it's safe to touch the db
+static volatile std::sig_atomic_t stop_requested = 0;
+
 void Server::run() {
     struct us_loop_t *loop = (struct us_loop_t *) uWS::Loop::get();
     struct us_timer_t *delayTimer = us_create_timer(loop, 0, 0);
 
-    us_timer_set(delayTimer, [](us_timer_t *x){ Server::tick(); }, 1, 1000 / TPS);
+    std::signal(SIGINT, [](int) { stop_requested = 1; });
+    std::signal(SIGTERM, [](int) { stop_requested = 1; });
+    us_timer_set(delayTimer, [](us_timer_t *x){
+        if (stop_requested) {
+            std::cout << "Shutting down, flushing queued account writes\n";
+            //deaths in the last post_tick land in the cache after that tick's flush
+            AccountCache::flush();
+            AuthDB::shutdown();
+            std::exit(0);
+        }
+        Server::tick();
+    }, 1, 1000 / TPS);
     Server::server.run();
 }
 
 void Client::send_packet(uint8_t const *packet, size_t size) {
     if (ws == nullptr) return;
     std::string_view message(reinterpret_cast<char const *>(packet), size);
-    ws->send(message, uWS::OpCode::BINARY, 0);
+    //ticks run off a timer, where uWS doesn't cork for us: without it the frame header and payload can be separate writes
+    ws->cork([&]() {
+#ifdef COMPRESS_UPDATES
+        //small deltas don't shrink enough to pay for the deflate call
+        ws->send(message, uWS::OpCode::BINARY, size >= COMPRESS_MIN_BYTES);
+#else
+        ws->send(message, uWS::OpCode::BINARY, 0);
+#endif
+    });
 }
 #endif
\ No newline at end of file
@@ -28,7 +28,7 @@ static void default_tick_idle_moving(Simulation *sim, Entity &ent) {
     }
     if (ent.ai_tick < 0.5 * TPS) return;
     float r = (ent.ai_tick - 0.5 * TPS) / (2 * TPS);
-    ent.acceleration
+    ent.acceleration()
         .unit_normal(ent.get_angle())
         .set_magnitude(2 * MOB_ACCELERATION * (r - r * r));
 }
@@ -49,7 +49,7 @@ static void default_tick_returning(Simulation *sim, Entity &ent, float speed = 1
         return;
     } 
     delta.set_magnitude(MOB_ACCELERATION * speed);
-    ent.acceleration = delta;
+    ent.acceleration() = delta;
     ent.set_angle(delta.angle());
 }
 
@@ -79,7 +79,7 @@ static void tick_default_neutral(Simulation *sim, Entity &ent) {
         Entity &target = sim->get_ent(ent.target);
         Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
         v.set_magnitude(MOB_ACCELERATION * 0.975);
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -98,7 +98,7 @@ static void tick_default_aggro(Simulation *sim, Entity &ent, float speed) {
         Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
         _focus_lose_clause(ent, v);
         v.set_magnitude(MOB_ACCELERATION * speed);
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -125,7 +125,7 @@ static void tick_bee_passive(Simulation *sim, Entity &ent) {
             v *= 1.5;
             if (ent.lifetime % (TPS * 3 / 2) < TPS / 2)
                 v *= 0.5;
-            ent.acceleration = v;
+            ent.acceleration() = v;
             break;
         }
         case AIState::kIdleMoving: {
@@ -149,9 +149,9 @@ static void tick_hornet_aggro(Simulation *sim, Entity &ent) {
         float dist = v.magnitude();
         if (dist > 300) {
             v.set_magnitude(MOB_ACCELERATION * 0.975);
-            ent.acceleration = v;
+            ent.acceleration() = v;
         } else {
-            ent.acceleration.set(0,0);
+            ent.acceleration().set(0,0);
         }
         ent.set_angle(v.angle());
         if (ent.ai_tick >= 1.5 * TPS && dist < 800) {
@@ -161,15 +161,15 @@ static void tick_hornet_aggro(Simulation *sim, Entity &ent) {
             missile.health = missile.max_health = 10;
             entity_set_despawn_tick(missile, 1.30f * TPS);
             missile.set_angle(ent.get_angle());
-            missile.acceleration.set(0,0);
-            missile.friction = 0.0f;
-            missile.velocity.unit_normal(ent.get_angle()).set_magnitude(60.0f);
-            missile.projectile_init_speed = missile.velocity.magnitude();
-            missile.projectile_target_ratio = 0.5f;
-            missile.projectile_decay_active = 1;
+            missile.acceleration().set(0,0);
+            missile.friction() = 0.0f;
+            missile.velocity().unit_normal(ent.get_angle()).set_magnitude(60.0f);
+            missile.projectile_init_speed() = missile.velocity().magnitude();
+            missile.projectile_target_ratio() = 0.5f;
+            missile.projectile_decay_active() = 1;
             Vector kb;
             kb.unit_normal(ent.get_angle() - M_PI).set_magnitude(2.5 * MOB_ACCELERATION);
-            ent.velocity += kb;            
+            ent.velocity() += kb;            
         }
         return;
     } else {
@@ -200,7 +200,7 @@ static void tick_centipede_passive(Simulation *sim, Entity &ent) {
             break;
         }
     }
-    ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION / 10);
+    ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION / 10);
 }
 
 static void tick_centipede_neutral(Simulation *sim, Entity &ent, float speed) {
@@ -208,7 +208,7 @@ static void tick_centipede_neutral(Simulation *sim, Entity &ent, float speed) {
         Entity &target = sim->get_ent(ent.target);
         Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
         v.set_magnitude(MOB_ACCELERATION * speed);
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -220,13 +220,13 @@ static void tick_centipede_neutral(Simulation *sim, Entity &ent, float speed) {
             case AIState::kIdle: {
                 ent.set_angle(ent.get_angle() + 0.25 / TPS);
                 if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdleMoving;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION * speed);
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION * speed);
                 break;
             }
             case AIState::kIdleMoving: {
                 ent.set_angle(ent.get_angle() - 0.25 / TPS);
                 if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdle;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION * speed);
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION * speed);
                 break;
             }
             case AIState::kReturning: {
@@ -243,7 +243,7 @@ static void tick_centipede_aggro(Simulation *sim, Entity &ent) {
         Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
         _focus_lose_clause(ent, v);
         v.set_magnitude(MOB_ACCELERATION * 0.95);
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -256,13 +256,13 @@ static void tick_centipede_aggro(Simulation *sim, Entity &ent) {
             case AIState::kIdle: {
                 ent.set_angle(ent.get_angle() + 0.25 / TPS);
                 if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdleMoving;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION / 10);
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION / 10);
                 break;
             }
             case AIState::kIdleMoving: {
                 ent.set_angle(ent.get_angle() - 0.25 / TPS);
                 if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdle;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION / 10);
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION / 10);
                 break;
             }
             case AIState::kReturning: {
@@ -282,7 +282,7 @@ static void tick_sandstorm(Simulation *sim, Entity &ent) {
                 ent.ai_state = AIState::kIdleMoving;
             }
             Vector rand = Vector::rand(MOB_ACCELERATION * 0.5);
-            ent.acceleration.set(rand.x, rand.y);
+            ent.acceleration().set(rand.x, rand.y);
             break;
         }
         case AIState::kIdleMoving: {
@@ -299,7 +299,7 @@ static void tick_sandstorm(Simulation *sim, Entity &ent) {
             rand.unit_normal(ent.heading_angle + frand() * M_PI - M_PI / 2);
             rand.set_magnitude(MOB_ACCELERATION * 0.5);
             head += rand;
-            ent.acceleration.set(head.x, head.y);
+            ent.acceleration().set(head.x, head.y);
             break;
         }
         case AIState::kReturning: {
@@ -312,7 +312,7 @@ static void tick_sandstorm(Simulation *sim, Entity &ent) {
     }
     if (sim->ent_alive(ent.get_parent())) {
         Entity &parent = sim->get_ent(ent.get_parent());
-        ent.acceleration = (ent.acceleration + parent.acceleration) * 0.75;
+        ent.acceleration() = (ent.acceleration() + parent.acceleration()) * 0.75;
     }
 }
 
@@ -329,7 +329,7 @@ static void tick_digger(Simulation *sim, Entity &ent) {
             BitMath::set(ent.input, InputFlags::kDefending);
             v *= -1;
         }
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -349,7 +349,7 @@ static void tick_digger(Simulation *sim, Entity &ent) {
             case AIState::kIdleMoving: {
                 if (ent.ai_tick > 5 * TPS)
                     ent.ai_state = AIState::kIdle;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION);
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(MOB_ACCELERATION);
                 break;
             }
             case AIState::kReturning: {
@@ -360,13 +360,45 @@ static void tick_digger(Simulation *sim, Entity &ent) {
     }
 }
 
+//mobs per job in the target lookup pass
+static uint32_t const AI_TARGET_CHUNK = 64;
+
+//mobs whose ai calls find_nearest_enemy when they have no target
+static uint8_t _hunts(Simulation *sim, Entity const &ent) {
+    if (sim->ent_alive(ent.target) || sim->ent_alive(ent.last_damaged_by)) return 0;
+    switch (ent.get_mob_id()) {
+        case MobID::kEvilCentipede:
+        case MobID::kSoldierAnt:
+        case MobID::kBeetle:
+        case MobID::kMassiveBeetle:
+        case MobID::kScorpion:
+        case MobID::kSpider:
+        case MobID::kQueenAnt:
+        case MobID::kHornet:
+        case MobID::kDigger:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+//the lookup is only an early answer: a mob skipped here still finds its target in the ai pass
+void tick_ai_targets(Simulation *sim) {
+    //queries rebuild a dirty grid, which can't happen from several jobs at once
+    sim->spatial_hash.flush();
+    sim->for_each_chunk<kMob>(AI_TARGET_CHUNK, [](Simulation *sim, Entity &ent, uint32_t) {
+        if (_hunts(sim, ent)) acquire_nearest_enemy(sim, ent);
+        else ent.nearest_enemy_dist = -1;
+    });
+}
+
 void tick_ai_behavior(Simulation *sim, Entity &ent) {
     if (ent.pending_delete) return;
     if (sim->ent_alive(ent.seg_head)) return;
-    ent.acceleration.set(0,0);
+    ent.acceleration().set(0,0);
     if (!(ent.get_parent() == NULL_ENTITY)) {
         if (!sim->ent_alive(ent.get_parent())) {
-            if (BitMath::at(ent.flags, EntityFlags::kDieOnParentDeath))
+            if (BitMath::at(ent.flags(), EntityFlags::kDieOnParentDeath))
                 sim->request_delete(ent.id);
             ent.set_parent(NULL_ENTITY);
         } else {
@@ -384,7 +416,7 @@ void tick_ai_behavior(Simulation *sim, Entity &ent) {
             }
         }
     }
-    if (BitMath::at(ent.flags, EntityFlags::kIsCulled)) {
+    if (BitMath::at(ent.flags(), EntityFlags::kIsCulled)) {
         ent.target = NULL_ENTITY;
         ent.ai_tick = 0;
         return;
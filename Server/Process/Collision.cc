@@ -4,10 +4,12 @@
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 
+#include <array>
 #include <cmath>
 #include <iostream>
+#include <vector>
 #ifndef WASM_SERVER
-#include <Server/AuthDB.hh>
+#include <Server/Account/AccountCache.hh>
 #else
 #include <Server/Account/WasmAccountStore.hh>
 #include <emscripten.h>
@@ -23,7 +25,7 @@ static bool _should_interact(Entity const &ent1, Entity const &ent2) {
     //if (ent1.has_component(kPetal) || ent2.has_component(kPetal)) return false;
     if (ent1.pending_delete || ent2.pending_delete) return false;
     if (!(ent1.get_team() == ent2.get_team())) return true;
-    if (BitMath::at((ent1.flags | ent2.flags), EntityFlags::kNoFriendlyCollision)) return false;
+    if (BitMath::at((ent1.flags() | ent2.flags()), EntityFlags::kNoFriendlyCollision)) return false;
     //if (ent1.has_component(kPetal) || ent2.has_component(kPetal)) return false;
     if (ent1.has_component(kMob) && ent2.has_component(kMob)) return true;
     return false;
@@ -39,23 +41,23 @@ static void _pickup_drop(Simulation *sim, Entity &player, Entity &drop) {
         player.set_loadout_ids(i, obtained);
         // Persist to account petal gallery when applicable
         if (obtained != PetalID::kNone) {
-            std::string acc = AccountLink::get_account_for_entity(player.id);
+            std::string const &acc = AccountLink::get_account_for_entity(player.id);
             if (!acc.empty()) {
 #ifndef WASM_SERVER
-                AuthDB::record_petal_obtained(acc, (int)obtained);
+                AccountCache::record_petal_obtained(acc, obtained);
 #else
                 WasmAccountStore::set_bit(WasmAccountStore::Category::PetalGallery, acc, (int)obtained);
                 // Forward to Node sqlite for persistence
                 EM_ASM({ try { Module.recordPetalObtained(UTF8ToString($0), $1); } catch(e) {} }, acc.c_str(), (int)obtained);
-#endif
 
                 Server::game.send_petal_gallery_to_account(acc);
+#endif
             }
         }
         // Finish pickup
         drop.set_x(player.get_x());
         drop.set_y(player.get_y());
-        BitMath::unset(drop.flags, EntityFlags::kIsDespawning);
+        BitMath::unset(drop.flags(), EntityFlags::kIsDespawning);
         sim->request_delete(drop.id);
         //peaceful transfer, no petal tracking needed
         return;
@@ -70,53 +72,84 @@ static void _pickup_drop(Simulation *sim, Entity &player, Entity &drop) {
 static void _deal_push(Entity &ent, Vector knockback, float mass_ratio, float scale) {
     if (fabsf(mass_ratio) < 0.01) return;
     knockback *= scale * mass_ratio;
-    ent.collision_velocity += knockback;
+    ent.collision_velocity() += knockback;
 }
 
 static void _deal_knockback(Entity &ent, Vector knockback, float mass_ratio) {
     if (fabsf(mass_ratio) < 0.01) return;
     float scale = MOB_ACCELERATION * 2;
     knockback *= scale * mass_ratio;
-    ent.collision_velocity += knockback;
-    ent.velocity += knockback * 2;
+    ent.collision_velocity() += knockback;
+    ent.velocity() += knockback * 2;
 }
 
 static void _cancel_movement(Entity &ent, Vector dir, Vector add) {
     Vector push = dir;
     push.normalize();
     float dot = fclamp(push.x * add.x + push.y * add.y, MOB_ACCELERATION * 0.5f, MOB_ACCELERATION * 25.0f);
-    ent.velocity += push * (MOB_ACCELERATION + dot * 2);
-    ent.collision_velocity += push * (0.5f * MOB_ACCELERATION);
+    ent.velocity() += push * (MOB_ACCELERATION + dot * 2);
+    ent.collision_velocity() += push * (0.5f * MOB_ACCELERATION);
 }
 
-void on_collide(Simulation *sim, Entity &ent1, Entity &ent2) {
+struct Contact {
+    EntityID a;
+    EntityID b;
+    //unit vector from b to a, left zero when both sit on the same spot
+    float nx;
+    float ny;
+    float dist;
+    float ratio;
+};
+
+//contacts found by each strip, kept around so their capacity is reused
+static std::array<std::vector<Contact>, COLLISION_STRIPS> strip_contacts;
+
+//read-only half of a collision, run on the job system one strip at a time
+//positions don't move and pending_delete only gets set while resolving,
+//so a pair rejected here would also have been rejected by a serial walk
+static void _find_contact(Simulation *sim, Entity const &ent1, Entity const &ent2, std::vector<Contact> &contacts) {
+    EntityHotFields const &hot = sim->hot_fields;
+    EntityID::id_type const a = ent1.id.id;
+    EntityID::id_type const b = ent2.id.id;
     //do a distance dependent check first (it's faster)
-    float min_dist = ent1.get_radius() + ent2.get_radius();
-    if (fabs(ent1.get_x() - ent2.get_x()) > min_dist || fabs(ent1.get_y() - ent2.get_y()) > min_dist) return;
+    float min_dist = hot.radius[a] + hot.radius[b];
+    float dx = hot.x[a] - hot.x[b];
+    float dy = hot.y[a] - hot.y[b];
+    if (fabs(dx) > min_dist || fabs(dy) > min_dist) return;
     //check if collide (distance independent)
     if (!_should_interact(ent1, ent2)) return;
     //finer distance check
-    Vector separation(ent1.get_x() - ent2.get_x(), ent1.get_y() - ent2.get_y());
+    Vector separation(dx, dy);
     float dist = min_dist - separation.magnitude();
     if (dist < 0) return;
+    if (separation.x != 0 || separation.y != 0) separation.normalize();
+    contacts.push_back({ ent1.id, ent2.id, separation.x, separation.y, dist, hot.mass[b] / (hot.mass[a] + hot.mass[b]) });
+}
+
+//applied in the order a serial walk finds the pairs, so velocities, frand() draws,
+//damage, deletes and pickups all see exactly what the earlier contacts left behind
+static void _resolve_contact(Simulation *sim, Contact const &contact) {
+    Entity &ent1 = sim->get_ent(contact.a);
+    Entity &ent2 = sim->get_ent(contact.b);
+    //an earlier contact may have killed or picked up one of them
+    if (!_should_interact(ent1, ent2)) return;
     if (NO(kDrop) && NO(kWeb)) {
+        Vector separation(contact.nx, contact.ny);
         if (separation.x == 0 && separation.y == 0)
             separation.unit_normal(frand() * 2 * M_PI);
-        else
-            separation.normalize();
-        float ratio = ent2.mass / (ent1.mass + ent2.mass);
+        float ratio = contact.ratio;
         if (!(ent1.get_team() == ent2.get_team())) {
             if (ent1.has_component(kFlower) && !ent2.has_component(kPetal))
-                _cancel_movement(ent1, separation, ent2.velocity - ent1.velocity);
+                _cancel_movement(ent1, separation, ent2.velocity() - ent1.velocity());
             else
                 _deal_knockback(ent1, separation, ratio);
             if (ent2.has_component(kFlower) && !ent1.has_component(kPetal))
-                _cancel_movement(ent2, separation*-1, ent1.velocity - ent2.velocity);
+                _cancel_movement(ent2, separation*-1, ent1.velocity() - ent2.velocity());
             else
                 _deal_knockback(ent2, separation*-1, 1 - ratio);
         }
-        _deal_push(ent1, separation, ratio, dist);
-        _deal_push(ent2, separation*-1, 1 - ratio, dist);
+        _deal_push(ent1, separation, ratio, contact.dist);
+        _deal_push(ent2, separation*-1, 1 - ratio, contact.dist);
     }
 
     if (BOTH(kHealth) && !(ent1.get_team() == ent2.get_team())) {
@@ -134,7 +167,18 @@ void on_collide(Simulation *sim, Entity &ent1, Entity &ent2) {
         _pickup_drop(sim, ent1, ent2);
 
     if (ent1.has_component(kWeb) && !ent2.has_component(kPetal) && !ent2.has_component(kDrop))
-        ent2.speed_ratio = 0.5;
+        ent2.speed_ratio() = 0.5;
     if (ent2.has_component(kWeb) && !ent1.has_component(kPetal) && !ent1.has_component(kDrop))
-        ent1.speed_ratio = 0.5;
-}
\ No newline at end of file
+        ent1.speed_ratio() = 0.5;
+}
+
+void tick_collision(Simulation *sim) {
+    for (std::vector<Contact> &contacts : strip_contacts) contacts.clear();
+    sim->spatial_hash.collide_strips([](Simulation *sim, Entity &ent1, Entity &ent2, uint32_t strip) {
+        _find_contact(sim, ent1, ent2, strip_contacts[strip]);
+    });
+    //strips cover the columns in order, so this matches the serial walk
+    for (std::vector<Contact> const &contacts : strip_contacts)
+        for (Contact const &contact : contacts)
+            _resolve_contact(sim, contact);
+}
@@ -5,11 +5,30 @@
 #include <Shared/Simulation.hh>
 #include <Shared/StaticData.hh>
 
+#include <vector>
+
 constexpr float CULL_EXTRA_RADIUS = 250;
+constexpr uint32_t CULL_CHUNK = 4;
+
+//entities seen by each run of cameras, merged once every camera is done
+static std::vector<std::array<uint64_t, ENTITY_CAP / 64>> visible;
 
-void tick_culling_behavior(Simulation *sim, Entity &ent) {
-    float fov = fclamp(ent.get_fov(), BASE_FOV * 0.1, BASE_FOV);
-    sim->spatial_hash.query(ent.get_camera_x(), ent.get_camera_y(), 960 / fov + CULL_EXTRA_RADIUS, 540 / fov + CULL_EXTRA_RADIUS, [](Simulation *, Entity &ent) {
-        BitMath::unset(ent.flags, EntityFlags::kIsCulled);
+void tick_culling_behavior(Simulation *sim) {
+    uint32_t const chunks = sim->chunk_count<kCamera>(CULL_CHUNK);
+    if (visible.size() < chunks) visible.resize(chunks);
+    for (uint32_t c = 0; c < chunks; ++c) visible[c].fill(0);
+    sim->spatial_hash.flush();
+    sim->for_each_chunk<kCamera>(CULL_CHUNK, [](Simulation *sim, Entity &ent, uint32_t chunk) {
+        std::array<uint64_t, ENTITY_CAP / 64> &seen = visible[chunk];
+        float fov = fclamp(ent.get_fov(), BASE_FOV * 0.1, BASE_FOV);
+        sim->spatial_hash.query(ent.get_camera_x(), ent.get_camera_y(), 960 / fov + CULL_EXTRA_RADIUS, 540 / fov + CULL_EXTRA_RADIUS, [&](Simulation *, Entity &ent) {
+            BitMath::set(seen[ent.id.id / 64], ent.id.id % 64);
+        });
     });
+    for (uint32_t w = 0; w < ENTITY_CAP / 64; ++w) {
+        uint64_t bits = 0;
+        for (uint32_t c = 0; c < chunks; ++c) bits |= visible[c][w];
+        for (; bits; bits &= bits - 1)
+            BitMath::unset(sim->hot_fields.flags[w * 64 + BitMath::lowest(bits)], EntityFlags::kIsCulled);
+    }
 }
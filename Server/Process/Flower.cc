@@ -148,7 +148,7 @@ void tick_player_behavior(Simulation *sim, Entity &player) {
             if (sim->ent_alive(petal_slot.ent_id)) {
                 Entity &petal = sim->get_ent(petal_slot.ent_id);
                 //only do this if petal not despawning
-                if (petal.has_component(kPetal) && !(BitMath::at(petal.flags, EntityFlags::kIsDespawning))) {
+                if (petal.has_component(kPetal) && !(BitMath::at(petal.flags(), EntityFlags::kIsDespawning))) {
                     //petal rotation behavior
                     Vector wanting;
                     Vector delta(player.get_x() - petal.get_x(), player.get_y() - petal.get_y());
@@ -176,7 +176,7 @@ void tick_player_behavior(Simulation *sim, Entity &player) {
                     }
                     wanting += delta;
                     wanting *= 0.5;
-                    petal.acceleration = wanting;
+                    petal.acceleration() = wanting;
                     game_tick_t sec_reload_ticks = petal_data.attributes.secondary_reload * TPS;
                                         if (petal_data.attributes.spawns != MobID::kNumMobs &&
                         petal.secondary_reload >= sec_reload_ticks) {
@@ -185,8 +185,8 @@ void tick_player_behavior(Simulation *sim, Entity &player) {
                         mob.set_parent(player.id);
                         mob.set_color(player.get_color());
                         mob.base_entity = player.id;
-                        BitMath::set(mob.flags, EntityFlags::kDieOnParentDeath);
-                        BitMath::set(mob.flags, EntityFlags::kNoDrops);
+                        BitMath::set(mob.flags(), EntityFlags::kDieOnParentDeath);
+                        BitMath::set(mob.flags(), EntityFlags::kNoDrops);
                         if (petal_data.attributes.spawn_count == 0) {
                             petal_slot.ent_id = mob.id;
                             sim->request_delete(petal.id);
@@ -201,7 +201,7 @@ void tick_player_behavior(Simulation *sim, Entity &player) {
                     }
                 } else {
                     //if petal is a mob, or detached (IsDespawning)
-                    if (BitMath::at(petal.flags, EntityFlags::kIsDespawning))
+                    if (BitMath::at(petal.flags(), EntityFlags::kIsDespawning))
                         petal_slot.ent_id = NULL_ENTITY;
                     if (petal.has_component(kMob))
                         --rot_pos;
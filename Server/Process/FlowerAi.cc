@@ -6,6 +6,6 @@
 
 void tick_player_ai_behavior(Simulation *sim, Entity &ent) {
     if (!sim->ent_alive(ent.get_player())) return;
-    if (!BitMath::at(ent.flags, EntityFlags::kCPUControlled)) return;
+    if (!BitMath::at(ent.flags(), EntityFlags::kCPUControlled)) return;
     // Decision making disabled: do nothing here
 }
\ No newline at end of file
@@ -3,52 +3,270 @@
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 #include <cmath>
+#include <vector>
 
-void tick_entity_motion(Simulation *sim, Entity &ent) {
-    if (ent.pending_delete) return;
-    if (ent.slow_ticks > 0) {
-        ent.speed_ratio *= 0.5;
-        --ent.slow_ticks;
+#if defined(__SSE2__) && !defined(SCALAR_MOTION)
+#define SIMD_MOTION
+#include <emmintrin.h>
+#endif
+
+#ifdef DEBUG
+#include <algorithm>
+#include <iostream>
+#endif
+
+struct MotionState {
+    Vector velocity;
+    Vector collision_velocity;
+    Vector acceleration;
+    float x;
+    float y;
+    float radius;
+    float friction;
+    float speed_ratio;
+    float projectile_init_speed;
+    float projectile_target_ratio;
+    game_tick_t slow_ticks;
+    uint8_t projectile_decay_active;
+    uint8_t clamp;
+};
+
+static uint8_t _should_clamp(Entity const &ent) {
+    return !ent.has_component(kPetal) && !ent.has_component(kWeb);
+}
+
+static void _load(EntityHotFields &hot, Entity const &ent, MotionState &s) {
+    EntityID::id_type const i = ent.id.id;
+    s.velocity = hot.velocity[i];
+    s.collision_velocity = hot.collision_velocity[i];
+    s.acceleration = hot.acceleration[i];
+    s.x = hot.x[i];
+    s.y = hot.y[i];
+    s.radius = hot.radius[i];
+    s.friction = hot.friction[i];
+    s.speed_ratio = hot.speed_ratio[i];
+    s.projectile_init_speed = hot.projectile_init_speed[i];
+    s.projectile_target_ratio = hot.projectile_target_ratio[i];
+    s.slow_ticks = hot.slow_ticks[i];
+    s.projectile_decay_active = hot.projectile_decay_active[i];
+    s.clamp = _should_clamp(ent);
+}
+
+static void _store(EntityHotFields &hot, Entity &ent, MotionState &s) {
+    EntityID::id_type const i = ent.id.id;
+    hot.velocity[i] = s.velocity;
+    hot.collision_velocity[i] = s.collision_velocity;
+    hot.speed_ratio[i] = s.speed_ratio;
+    hot.projectile_init_speed[i] = s.projectile_init_speed;
+    hot.projectile_target_ratio[i] = s.projectile_target_ratio;
+    hot.slow_ticks[i] = s.slow_ticks;
+    hot.projectile_decay_active[i] = s.projectile_decay_active;
+    //setters flag the change for the protocol
+    ent.set_x(s.x);
+    ent.set_y(s.y);
+}
+
+static void _projectile_decay(Vector &velocity, float &init_speed, float &target_ratio, uint8_t &active) {
+    float speed = velocity.magnitude();
+    if (init_speed == 0 && speed > 0) {
+        init_speed = speed;
+        if (target_ratio == 0) target_ratio = 0.58f;
+    }
+    float ratio = target_ratio > 0 ? target_ratio : 0.8f;
+    float decay_ticks = 10.0f;
+    float factor = powf(ratio, 1.0f / decay_ticks);
+    if (init_speed > 0 && speed > ratio * init_speed) {
+        if (speed > 0) {
+            float new_mag = speed * factor;
+            float target = ratio * init_speed;
+            if (new_mag < target) new_mag = target;
+            velocity.set_magnitude(new_mag);
+        }
+    } else if (init_speed > 0) {
+        float target = ratio * init_speed;
+        if (speed > 0) velocity.set_magnitude(target);
+        active = 0;
+    }
+}
+
+//reference implementation, also used for the batch tail
+static void _step(MotionState &s) {
+    if (s.slow_ticks > 0) {
+        s.speed_ratio *= 0.5;
+        --s.slow_ticks;
+    }
+
+    s.velocity *= (1 - s.friction);
+
+    if (s.projectile_decay_active)
+        _projectile_decay(s.velocity, s.projectile_init_speed, s.projectile_target_ratio, s.projectile_decay_active);
+
+    s.velocity += (s.acceleration * s.speed_ratio);
+
+    s.x = s.x + s.velocity.x + s.collision_velocity.x;
+    s.y = s.y + s.velocity.y + s.collision_velocity.y;
+    s.collision_velocity *= 0.5;
+    s.velocity += s.collision_velocity;
+
+    if (s.clamp) {
+        s.x = fclamp(s.x, s.radius, ARENA_WIDTH - s.radius);
+        s.y = fclamp(s.y, s.radius, ARENA_HEIGHT - s.radius);
     }
 
-    ent.velocity *= (1 - ent.friction);
+    //s.acceleration.set(0,0);
+    s.collision_velocity.set(0,0);
+    s.speed_ratio = 1;
+}
+
+#ifdef SIMD_MOTION
+static uint32_t const MOTION_LANES = 4;
+
+//same as fclamp, including which bound wins when s > e
+static __m128 _clamp4(__m128 v, __m128 s, __m128 e) {
+    __m128 le = _mm_cmple_ps(v, e);
+    __m128 r = _mm_or_ps(_mm_and_ps(le, v), _mm_andnot_ps(le, e));
+    __m128 ge = _mm_cmpge_ps(v, s);
+    return _mm_or_ps(_mm_and_ps(ge, r), _mm_andnot_ps(ge, s));
+}
 
-    if (ent.projectile_decay_active) {
-        float speed = ent.velocity.magnitude();
-        if (ent.projectile_init_speed == 0 && speed > 0) {
-            ent.projectile_init_speed = speed;
-            if (ent.projectile_target_ratio == 0) ent.projectile_target_ratio = 0.58f;
+static __m128 _select4(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//integrates MOTION_LANES entities at once, mirroring _step
+static void _step_batch(EntityHotFields &hot, Entity **ents) {
+    alignas(16) float x[MOTION_LANES], y[MOTION_LANES], radius[MOTION_LANES];
+    alignas(16) float vx[MOTION_LANES], vy[MOTION_LANES], cvx[MOTION_LANES], cvy[MOTION_LANES];
+    alignas(16) float ax[MOTION_LANES], ay[MOTION_LANES], friction[MOTION_LANES], speed_ratio[MOTION_LANES];
+    alignas(16) uint32_t clamp[MOTION_LANES];
+    uint32_t decay_mask = 0;
+    #ifdef DEBUG
+    MotionState expected[MOTION_LANES];
+    for (uint32_t l = 0; l < MOTION_LANES; ++l) {
+        _load(hot, *ents[l], expected[l]);
+        _step(expected[l]);
+    }
+    #endif
+    for (uint32_t l = 0; l < MOTION_LANES; ++l) {
+        EntityID::id_type const i = ents[l]->id.id;
+        x[l] = hot.x[i];
+        y[l] = hot.y[i];
+        radius[l] = hot.radius[i];
+        vx[l] = hot.velocity[i].x;
+        vy[l] = hot.velocity[i].y;
+        cvx[l] = hot.collision_velocity[i].x;
+        cvy[l] = hot.collision_velocity[i].y;
+        ax[l] = hot.acceleration[i].x;
+        ay[l] = hot.acceleration[i].y;
+        friction[l] = hot.friction[i];
+        speed_ratio[l] = hot.speed_ratio[i];
+        if (hot.slow_ticks[i] > 0) {
+            speed_ratio[l] *= 0.5;
+            --hot.slow_ticks[i];
         }
-        float ratio = ent.projectile_target_ratio > 0 ? ent.projectile_target_ratio : 0.8f;
-        float decay_ticks = 10.0f;
-        float factor = powf(ratio, 1.0f / decay_ticks);
-        if (ent.projectile_init_speed > 0 && speed > ratio * ent.projectile_init_speed) {
-            if (speed > 0) {
-                float new_mag = speed * factor;
-                float target = ratio * ent.projectile_init_speed;
-                if (new_mag < target) new_mag = target;
-                ent.velocity.set_magnitude(new_mag);
-            }
-        } else if (ent.projectile_init_speed > 0) {
-            float target = ratio * ent.projectile_init_speed;
-            if (speed > 0) ent.velocity.set_magnitude(target);
-            ent.projectile_decay_active = 0;
+        clamp[l] = _should_clamp(*ents[l]) ? ~0u : 0;
+        if (hot.projectile_decay_active[i]) BitMath::set(decay_mask, l);
+    }
+
+    __m128 const one = _mm_set1_ps(1);
+    __m128 const half = _mm_set1_ps(0.5);
+    __m128 v_x = _mm_load_ps(vx);
+    __m128 v_y = _mm_load_ps(vy);
+    __m128 damp = _mm_sub_ps(one, _mm_load_ps(friction));
+    v_x = _mm_mul_ps(v_x, damp);
+    v_y = _mm_mul_ps(v_y, damp);
+
+    //projectile decay is rare and needs powf, so only those lanes take the scalar path
+    if (decay_mask) {
+        _mm_store_ps(vx, v_x);
+        _mm_store_ps(vy, v_y);
+        for (uint32_t l = 0; l < MOTION_LANES; ++l) {
+            if (!BitMath::at(decay_mask, l)) continue;
+            EntityID::id_type const i = ents[l]->id.id;
+            Vector v(vx[l], vy[l]);
+            _projectile_decay(v, hot.projectile_init_speed[i], hot.projectile_target_ratio[i], hot.projectile_decay_active[i]);
+            vx[l] = v.x;
+            vy[l] = v.y;
         }
+        v_x = _mm_load_ps(vx);
+        v_y = _mm_load_ps(vy);
     }
 
-    ent.velocity += (ent.acceleration * ent.speed_ratio);
+    __m128 sr = _mm_load_ps(speed_ratio);
+    v_x = _mm_add_ps(v_x, _mm_mul_ps(_mm_load_ps(ax), sr));
+    v_y = _mm_add_ps(v_y, _mm_mul_ps(_mm_load_ps(ay), sr));
 
-    ent.set_x(ent.get_x() + ent.velocity.x + ent.collision_velocity.x);
-    ent.set_y(ent.get_y() + ent.velocity.y + ent.collision_velocity.y);
-    ent.collision_velocity *= 0.5;
-    ent.velocity += ent.collision_velocity;
+    __m128 cv_x = _mm_load_ps(cvx);
+    __m128 cv_y = _mm_load_ps(cvy);
+    __m128 p_x = _mm_add_ps(_mm_add_ps(_mm_load_ps(x), v_x), cv_x);
+    __m128 p_y = _mm_add_ps(_mm_add_ps(_mm_load_ps(y), v_y), cv_y);
+    v_x = _mm_add_ps(v_x, _mm_mul_ps(cv_x, half));
+    v_y = _mm_add_ps(v_y, _mm_mul_ps(cv_y, half));
 
-    if (!ent.has_component(kPetal) && !ent.has_component(kWeb)) {
-        ent.set_x(fclamp(ent.get_x(), ent.get_radius(), ARENA_WIDTH - ent.get_radius()));
-        ent.set_y(fclamp(ent.get_y(), ent.get_radius(), ARENA_HEIGHT - ent.get_radius()));
+    __m128 r = _mm_load_ps(radius);
+    __m128 clamp_mask = _mm_castsi128_ps(_mm_load_si128((__m128i const *) clamp));
+    p_x = _select4(clamp_mask, _clamp4(p_x, r, _mm_sub_ps(_mm_set1_ps(ARENA_WIDTH), r)), p_x);
+    p_y = _select4(clamp_mask, _clamp4(p_y, r, _mm_sub_ps(_mm_set1_ps(ARENA_HEIGHT), r)), p_y);
+
+    _mm_store_ps(x, p_x);
+    _mm_store_ps(y, p_y);
+    _mm_store_ps(vx, v_x);
+    _mm_store_ps(vy, v_y);
+    for (uint32_t l = 0; l < MOTION_LANES; ++l) {
+        EntityID::id_type const i = ents[l]->id.id;
+        hot.velocity[i].set(vx[l], vy[l]);
+        hot.collision_velocity[i].set(0,0);
+        hot.speed_ratio[i] = 1;
+        //setters flag the change for the protocol
+        ents[l]->set_x(x[l]);
+        ents[l]->set_y(y[l]);
+    }
+    #ifdef DEBUG
+    for (uint32_t l = 0; l < MOTION_LANES; ++l) {
+        EntityID::id_type const i = ents[l]->id.id;
+        float err = std::max({
+            fabsf(expected[l].x - hot.x[i]), fabsf(expected[l].y - hot.y[i]),
+            fabsf(expected[l].velocity.x - hot.velocity[i].x), fabsf(expected[l].velocity.y - hot.velocity[i].y)
+        });
+        if (err > 1e-3f) std::cout << "simd motion mismatch " << i << " err " << err << "\n";
+        assert(err <= 1e-3f);
     }
+    #endif
+}
+#endif
 
-    //ent.acceleration.set(0,0);
-    ent.collision_velocity.set(0,0);
-    ent.speed_ratio = 1;
-}
\ No newline at end of file
+//entities per job; fixed so batching doesn't depend on the thread count
+static uint32_t const MOTION_CHUNK = 256;
+
+void tick_entity_motion(Simulation *sim) {
+    EntityHotFields &hot = sim->hot_fields;
+    #ifdef SIMD_MOTION
+    struct Batch {
+        Entity *ents[MOTION_LANES];
+        uint32_t size = 0;
+    };
+    std::vector<Batch> batches(sim->chunk_count<kPhysics>(MOTION_CHUNK));
+    sim->for_each_chunk<kPhysics>(MOTION_CHUNK, [&](Simulation *sim, Entity &ent, uint32_t chunk) {
+        Batch &batch = batches[chunk];
+        batch.ents[batch.size++] = &ent;
+        if (batch.size < MOTION_LANES) return;
+        _step_batch(hot, batch.ents);
+        batch.size = 0;
+    });
+    for (Batch &batch : batches) {
+        for (uint32_t l = 0; l < batch.size; ++l) {
+            MotionState s;
+            _load(hot, *batch.ents[l], s);
+            _step(s);
+            _store(hot, *batch.ents[l], s);
+        }
+    }
+    #else
+    sim->for_each_chunk<kPhysics>(MOTION_CHUNK, [&](Simulation *sim, Entity &ent, uint32_t) {
+        MotionState s;
+        _load(hot, ent, s);
+        _step(s);
+        _store(hot, ent, s);
+    });
+    #endif
+}
@@ -9,13 +9,13 @@
 #include <cmath>
 
 static inline void launch_projectile(Simulation *sim, Entity &proj, float angle, float lifetime_ticks, float initial_speed, float target_ratio = 0.5f) {
-    proj.acceleration.set(0,0);
-    proj.friction = 0.0f;
-    proj.velocity.unit_normal(angle).set_magnitude(initial_speed);
+    proj.acceleration().set(0,0);
+    proj.friction() = 0.0f;
+    proj.velocity().unit_normal(angle).set_magnitude(initial_speed);
     entity_set_despawn_tick(proj, (game_tick_t)lifetime_ticks);
-    proj.projectile_init_speed = proj.velocity.magnitude();
-    proj.projectile_target_ratio = target_ratio;
-    proj.projectile_decay_active = 1;
+    proj.projectile_init_speed() = proj.velocity().magnitude();
+    proj.projectile_target_ratio() = target_ratio;
+    proj.projectile_decay_active() = 1;
 }
 
 void tick_petal_behavior(Simulation *sim, Entity &petal) {
@@ -30,12 +30,12 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
         float rot_amt = petal.get_petal_id() == PetalID::kWing ? 10.0 : 1.0;
         if (petal.id.id % 2) petal.set_angle(petal.get_angle() + rot_amt / TPS);
         else petal.set_angle(petal.get_angle() - rot_amt / TPS);
-        } else if (petal_data.attributes.rotation_style == PetalAttributes::kFollowRot && !(BitMath::at(petal.flags, EntityFlags::kIsDespawning))) {
+        } else if (petal_data.attributes.rotation_style == PetalAttributes::kFollowRot && !(BitMath::at(petal.flags(), EntityFlags::kIsDespawning))) {
         Vector delta(petal.get_x() - player.get_x(), petal.get_y() - player.get_y());
         petal.set_angle(delta.angle());
     }
-    if (BitMath::at(petal.flags, EntityFlags::kIsDespawning)) {
-        petal.acceleration.set(0,0);
+    if (BitMath::at(petal.flags(), EntityFlags::kIsDespawning)) {
+        petal.acceleration().set(0,0);
         return;
     }
     if (petal_data.attributes.secondary_reload == 0) return;
@@ -51,7 +51,7 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
             return;
         }
         delta.set_magnitude(PLAYER_ACCELERATION * 4);
-        petal.acceleration = delta;
+        petal.acceleration() = delta;
     }
         switch (petal.get_petal_id()) {
         case PetalID::kMissile:
@@ -79,7 +79,7 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
             if (BitMath::at(player.input, InputFlags::kDefending)) {
                 Vector v(player.get_x() - petal.get_x(), player.get_y() - petal.get_y());
                 v.set_magnitude(PLAYER_ACCELERATION * 20);
-                player.velocity += v;
+                player.velocity() += v;
                 sim->request_delete(petal.id);
             }
             break;
@@ -99,11 +99,11 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
                 float const pushMag = isAttacking ? attackPushMag : defendPushMag;
                 float const dir = isAttacking ? 1.0f : -1.0f;
 
-                petal.velocity.set(0, 0);
-                petal.acceleration.set(0, 0);
-                petal.velocity += delta * (pushMag * dir);
-                petal.friction = DEFAULT_FRICTION;
-                petal.projectile_decay_active = 0;
+                petal.velocity().set(0, 0);
+                petal.acceleration().set(0, 0);
+                petal.velocity() += delta * (pushMag * dir);
+                petal.friction() = DEFAULT_FRICTION;
+                petal.projectile_decay_active() = 0;
                 entity_set_despawn_tick(petal, 4.0 * TPS);
                 petal.secondary_reload = 0;
             }
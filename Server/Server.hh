@@ -7,6 +7,11 @@
 class Client;
 
 size_t const MAX_PACKET_LEN = 64 * 1024;
+//packets below this are sent uncompressed when COMPRESS_UPDATES is on
+size_t const COMPRESS_MIN_BYTES = 128;
+//entity bytes per client per tick for updates that may be held back; creates, deletions
+//and everything close to the player always go out on top of this
+size_t const UPDATE_BYTE_BUDGET = 1024;
 
 #ifdef WASM_SERVER
 class WebSocketServer {
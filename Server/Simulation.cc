@@ -3,72 +3,156 @@
 #include <Server/Process.hh>
 #include <Server/Client.hh>
 #include <Server/EntityFunctions.hh>
+#include <Server/JobSystem.hh>
 #include <Server/Server.hh>
 #include <Server/Spawn.hh>
 #include <Server/SpatialHash.hh>
 
 #include <Shared/Map.hh>
 
-#include <algorithm>
 #include <vector>
 
 static void calculate_leaderboard(Simulation *sim) {
-    std::vector<Entity const *> players;
-    sim->for_each<kCamera>([&](Simulation *sim, Entity &ent) { 
-        if (sim->ent_alive(ent.get_player())) players.push_back(&sim->get_ent(ent.get_player()));
+    Leaderboard &board = sim->leaderboard;
+    //for_each skips flowers deleted this tick, so leavers are found by walking the board
+    board.remove_if([&](EntityID const &id) {
+        return !sim->ent_alive(id) || !sim->ent_alive(sim->get_ent(id).get_parent());
     });
-    std::stable_sort(players.begin(), players.end(), [](Entity const *a, Entity const *b){
-        return a->get_score() > b->get_score();
+    //only flowers that joined or had their score set move in the ranking
+    sim->for_each<kFlower>([&](Simulation *sim, Entity &ent) {
+        if (!sim->ent_alive(ent.get_parent())) return;
+        if (!board.contains(ent.id) || ent.get_state_score()) board.update(ent);
+        else if (ent.get_state_name() || ent.get_state_color()) board.changed = 1;
     });
-    uint32_t num = players.size();
-    sim->arena_info.set_player_count(num);
-    num = std::min(num, LEADERBOARD_SIZE);
-        for (uint32_t i = 0; i < num; ++i) {
-        sim->arena_info.set_names(i, players[i]->get_name());
-        sim->arena_info.set_scores(i, players[i]->get_score());
-        sim->arena_info.set_colors(i, players[i]->get_color());
-        sim->arena_info.set_ids(i, players[i]->id);
+    if (!board.changed) return;
+    board.changed = 0;
+    sim->arena_info.set_player_count(board.size());
+    //setters skip unchanged values, so only slots whose occupant or score moved are sent
+    uint32_t i = 0;
+    board.for_each_top(LEADERBOARD_SIZE, [&](EntityID const &id) {
+        Entity const &player = sim->get_ent(id);
+        sim->arena_info.set_names(i, player.get_name());
+        sim->arena_info.set_scores(i, player.get_score());
+        sim->arena_info.set_colors(i, player.get_color());
+        sim->arena_info.set_ids(i, player.id);
+        ++i;
+    });
+}
+
+//what a tick stage touches
+//consecutive stages whose sets don't conflict run side by side on the job system
+namespace TickAccess {
+    enum : uint32_t {
+        kRng          = 1 << 0,  //frand()
+        kLifecycle    = 1 << 1,  //alloc, request_delete, pending_delete, components
+        kSpatialHash  = 1 << 2,
+        kPosition     = 1 << 3,  //x, y, radius, angle
+        kMotion       = 1 << 4,  //velocity, acceleration, collision_velocity, speed_ratio
+        kFlags        = 1 << 5,
+        kCameraFields = 1 << 6,  //camera_x, camera_y, fov
+        kPlayerFields = 1 << 7,  //loadout, overlevel_timer, name, color
+        kScoreFields  = 1 << 8,
+        kReferences   = 1 << 9,  //EntityID fields
+        kArena        = 1 << 10,
+        kEverything   = ~0u
+    };
+}
+
+struct TickStage {
+    char const *name;
+    uint32_t reads;
+    uint32_t writes;
+    void (*run)(Simulation *);
+};
+
+using namespace TickAccess;
+
+//stages that roll dice, spawn or deal damage touch nearly everything, so they are left exclusive
+static TickStage const TICK_STAGES[] = {
+    { "spawn", kEverything, kEverything, [](Simulation *sim) {
+        if (frand() < 1.0f / TPS) {
+            for (uint32_t i = 0; i < 10; ++i) {
+                Vector v;
+                if (Map::find_spawn_location(sim, 500, v))
+                    Map::spawn_random_mob(sim, v.x, v.y);
+            }
+        }
+    } },
+    { "track", kPosition | kLifecycle | kFlags, kSpatialHash | kFlags, [](Simulation *sim) {
+        sim->for_each_entity([](Simulation *sim, Entity &ent) {
+            if (ent.has_component(kPhysics))
+                sim->spatial_hash.insert(ent);
+            if (BitMath::at(ent.flags(), EntityFlags::kHasCulling))
+                BitMath::set(ent.flags(), EntityFlags::kIsCulled);
+        });
+    } },
+    { "culling", kCameraFields | kPosition | kSpatialHash | kLifecycle, kSpatialHash | kFlags, tick_culling_behavior },
+    { "player", kEverything, kEverything, [](Simulation *sim) { sim->for_each<kFlower>(tick_player_behavior); } },
+    //target lookups only read positions and the grid, so they fan out ahead of the serial ai pass
+    { "ai_targets", kPosition | kSpatialHash | kLifecycle | kFlags | kReferences, kSpatialHash | kReferences, tick_ai_targets },
+    { "ai", kEverything, kEverything, [](Simulation *sim) { sim->for_each<kMob>(tick_ai_behavior); } },
+    { "player_ai", kEverything, kEverything, [](Simulation *sim) { sim->for_each<kCamera>(tick_player_ai_behavior); } },
+    { "petal", kEverything, kEverything, [](Simulation *sim) { sim->for_each<kPetal>(tick_petal_behavior); } },
+    { "health", kEverything, kEverything, [](Simulation *sim) { sim->for_each<kHealth>(tick_health_behavior); } },
+    { "collision", kEverything, kEverything, tick_collision },
+    { "curse", kEverything, kEverything, tick_curse_behavior },
+    { "motion", kMotion | kPosition | kLifecycle, kMotion | kPosition, tick_entity_motion },
+    { "segment", kPosition | kReferences | kLifecycle, kPosition | kReferences, [](Simulation *sim) {
+        sim->for_each<kSegmented>(tick_segment_behavior);
+    } },
+    { "camera", kPosition | kMotion | kFlags | kScoreFields | kReferences | kLifecycle | kPlayerFields | kCameraFields,
+        kCameraFields | kPlayerFields | kPosition | kReferences | kLifecycle, [](Simulation *sim) {
+        sim->for_each<kCamera>(tick_camera_behavior);
+    } },
+    //score and references share a wave: score only writes the plain score_reward member,
+    //references only writes EntityID fields and their state bits
+    { "score", kScoreFields | kLifecycle, kScoreFields, [](Simulation *sim) { sim->for_each<kScore>(tick_score_behavior); } },
+    { "references", kReferences | kLifecycle, kReferences, [](Simulation *sim) {
+        sim->for_each_entity(entity_clear_references);
+    } },
+    { "leaderboard", kCameraFields | kPlayerFields | kScoreFields | kReferences | kLifecycle, kArena, calculate_leaderboard },
+};
+
+static bool _conflicts(TickStage const &a, TickStage const &b) {
+    return (a.writes & (b.reads | b.writes)) || (b.writes & a.reads);
+}
+
+static std::vector<std::vector<TickStage const *>> _plan_waves() {
+    std::vector<std::vector<TickStage const *>> waves;
+    for (TickStage const &stage : TICK_STAGES) {
+        bool fits = !waves.empty();
+        if (fits)
+            for (TickStage const *other : waves.back())
+                if (_conflicts(stage, *other)) fits = false;
+        if (!fits) waves.emplace_back();
+        waves.back().push_back(&stage);
     }
+    return waves;
 }
 
 void Simulation::on_tick() {
-    spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
-    if (frand() < 1.0f / TPS) {
-        for (uint32_t i = 0; i < 10; ++i) {
-            Vector v;
-            if (Map::find_spawn_location(this, 500, v))
-                Map::spawn_random_mob(this, v.x, v.y);
+    static std::vector<std::vector<TickStage const *>> const waves = _plan_waves();
+    for (std::vector<TickStage const *> const &wave : waves) {
+        if (wave.size() == 1) {
+            wave[0]->run(this);
+            continue;
         }
+        JobSystem::shared().parallel_for(wave.size(), [&](uint32_t i) { wave[i]->run(this); });
     }
-    for_each_entity([](Simulation *sim, Entity &ent) {
-        if (ent.has_component(kPhysics))
-            sim->spatial_hash.insert(ent);
-        if (BitMath::at(ent.flags, EntityFlags::kHasCulling))
-            BitMath::set(ent.flags, EntityFlags::kIsCulled);
-    });
-    for_each<kCamera>(tick_culling_behavior);
-    for_each<kFlower>(tick_player_behavior);
-    for_each<kMob>(tick_ai_behavior);
-    for_each<kCamera>(tick_player_ai_behavior);
-    for_each<kPetal>(tick_petal_behavior);
-    for_each<kHealth>(tick_health_behavior);
-    spatial_hash.collide(on_collide);
-    tick_curse_behavior(this);
-    for_each<kPhysics>(tick_entity_motion);
-    for_each<kSegmented>(tick_segment_behavior);
-    for_each<kCamera>(tick_camera_behavior);
-    for_each<kScore>(tick_score_behavior);
-    for_each_entity(entity_clear_references);
-    calculate_leaderboard(this);
+}
+
+void Simulation::_run_chunks(uint32_t count, std::function<void(uint32_t)> const &fn) {
+    JobSystem::shared().parallel_for(count, fn);
 }
 
 void Simulation::post_tick() {
     arena_info.reset_protocol();
+    delta_cache.invalidate();
     for_each_entity([](Simulation *sim, Entity &ent) {
         //no deletions mid tick
         ent.reset_protocol();
         ++ent.lifetime;
-        if (BitMath::at(ent.flags, EntityFlags::kIsDespawning)) {
+        if (BitMath::at(ent.flags(), EntityFlags::kIsDespawning)) {
             if (ent.despawn_tick == 0) sim->request_delete(ent.id);
             else --ent.despawn_tick;
         }
@@ -0,0 +1,83 @@
+#include <Server/SpatialHash.hh>
+
+#include <Server/JobSystem.hh>
+
+#include <Shared/Simulation.hh>
+#include <Shared/Entity.hh>
+
+#include <algorithm>
+
+SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), entities(sim->entities.data()), width(1), height(1) {
+    refresh(ARENA_WIDTH, ARENA_HEIGHT);
+}
+
+void SpatialHash::refresh(uint32_t _width, uint32_t _height) {
+    DEBUG_ONLY(assert(_width <= ARENA_WIDTH && _height <= ARENA_HEIGHT));
+    width = div_round_up(_width, GRID_SIZE);
+    height = div_round_up(_height, GRID_SIZE);
+    cell_entries.clear();
+    cell_start.fill(0);
+    tracked.fill(0);
+    dirty = 0;
+}
+
+void SpatialHash::insert(Entity const &ent) {
+    DEBUG_ONLY(assert(ent.has_component(kPhysics));)
+    EntityID::id_type const i = ent.id.id;
+    CellRange range = _cell_range(ent);
+    //most entities stay within the same cells between ticks
+    if (BitMath::at(tracked[i / 64], i % 64) && ranges[i] == range) return;
+    BitMath::set(tracked[i / 64], i % 64);
+    ranges[i] = range;
+    dirty = 1;
+}
+
+void SpatialHash::remove(EntityID const &id) {
+    if (!BitMath::at(tracked[id.id / 64], id.id % 64)) return;
+    BitMath::unset(tracked[id.id / 64], id.id % 64);
+    dirty = 1;
+}
+
+void SpatialHash::flush() {
+    if (dirty) _rebuild();
+}
+
+void SpatialHash::_rebuild() {
+    //counting sort of every tracked entity into its cells
+    cell_start.fill(0);
+    for (uint32_t w = 0; w < tracked.size(); ++w) {
+        for (uint64_t bits = tracked[w]; bits; bits &= bits - 1) {
+            CellRange const &r = ranges[w * 64 + BitMath::lowest(bits)];
+            for (uint32_t x = r.sx; x <= r.ex; ++x)
+                for (uint32_t y = r.sy; y <= r.ey; ++y)
+                    ++cell_start[x * MAX_GRID_Y + y + 1];
+        }
+    }
+    for (uint32_t c = 1; c < cell_start.size(); ++c)
+        cell_start[c] += cell_start[c - 1];
+    cell_entries.resize(cell_start.back());
+    std::array<uint32_t, MAX_GRID_X * MAX_GRID_Y> cursor;
+    std::copy(cell_start.begin(), cell_start.end() - 1, cursor.begin());
+    for (uint32_t w = 0; w < tracked.size(); ++w) {
+        for (uint64_t bits = tracked[w]; bits; bits &= bits - 1) {
+            EntityID::id_type const i = w * 64 + BitMath::lowest(bits);
+            CellRange const &r = ranges[i];
+            for (uint32_t x = r.sx; x <= r.ex; ++x)
+                for (uint32_t y = r.sy; y <= r.ey; ++y)
+                    cell_entries[cursor[x * MAX_GRID_Y + y]++] = i;
+        }
+    }
+    dirty = 0;
+}
+
+void SpatialHash::_run_strips(std::function<void(uint32_t)> const &fn) {
+    JobSystem::shared().parallel_for(COLLISION_STRIPS, fn);
+}
+
+void SpatialHash::collide(std::function<void(Simulation *, Entity &, Entity &)> on_collide) {
+    collide<std::function<void(Simulation *, Entity &, Entity &)> &>(on_collide);
+}
+
+void SpatialHash::query(float x, float y, float w, float h, std::function<void(Simulation *, Entity &)> cb) {
+    query<std::function<void(Simulation *, Entity &)> &>(x, y, w, h, cb);
+}
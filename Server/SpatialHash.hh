@@ -3,6 +3,8 @@
 #include <Shared/Entity.hh>
 #include <Shared/StaticData.hh>
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <vector>
@@ -14,15 +16,176 @@ static const uint32_t GRID_SIZE = 100 * 2;
 static const uint32_t MAX_GRID_X = div_round_up(ARENA_WIDTH, GRID_SIZE);
 static const uint32_t MAX_GRID_Y = div_round_up(ARENA_HEIGHT, GRID_SIZE);
 
+static_assert(MAX_GRID_X <= 256 && MAX_GRID_Y <= 256);
+
+//column strips the parallel collision pass is split into
+static const uint32_t COLLISION_STRIPS = 25;
+static const uint32_t STRIP_WIDTH = div_round_up(MAX_GRID_X, COLLISION_STRIPS);
+
 class SpatialHash {
+    struct CellRange {
+        uint8_t sx;
+        uint8_t sy;
+        uint8_t ex;
+        uint8_t ey;
+        bool operator==(CellRange const &) const = default;
+    };
     Simulation *simulation;
-    std::vector<EntityID> cells[MAX_GRID_X][MAX_GRID_Y];
+    //Simulation's entity array, so the visitors below don't need the full Simulation type
+    Entity *entities;
+    //flat cell storage, counting-sorted by cell whenever a tracked range changes
+    //cell c holds cell_entries[cell_start[c]] up to cell_entries[cell_start[c + 1]]
+    std::vector<EntityID::id_type> cell_entries;
+    std::array<uint32_t, MAX_GRID_X * MAX_GRID_Y + 1> cell_start;
+    std::array<CellRange, ENTITY_CAP> ranges;
+    std::array<uint64_t, ENTITY_CAP / 64> tracked;
     uint32_t width;
     uint32_t height;
+    uint8_t dirty;
+    CellRange _cell_range(Entity const &) const;
+    void _rebuild();
+    void _run_strips(std::function<void(uint32_t)> const &);
+    //walks the pairs owned by columns [x0, x1)
+    template <typename Callback>
+    void _collide_columns(uint32_t, uint32_t, Callback &&);
+    EntityID::id_type const *_cell_begin(uint32_t x, uint32_t y) const {
+        return cell_entries.data() + cell_start[x * MAX_GRID_Y + y];
+    }
+    uint32_t _cell_size(uint32_t x, uint32_t y) const {
+        return cell_start[x * MAX_GRID_Y + y + 1] - cell_start[x * MAX_GRID_Y + y];
+    }
 public:
     SpatialHash(Simulation *);
     void refresh(uint32_t, uint32_t);
+    //adds the entity, or moves it if the cells it covers changed
     void insert(Entity const &);
+    void remove(EntityID const &);
+    //sorts pending changes into the cells now; queries only read after this, so they can run concurrently
+    void flush();
+    //callback is inlined into the grid walk; the std::function overloads wrap these
+    template <typename Callback>
+    void collide(Callback &&);
+    //callback runs on the job system, one strip of columns per job, and also gets the strip index
+    //so it can write per-strip output; strips don't depend on the thread count and run in order without workers
+    template <typename Callback>
+    void collide_strips(Callback &&);
+    template <typename Callback>
+    void query(float, float, float, float, Callback &&);
     void collide(std::function<void(Simulation *, Entity &, Entity &)>);
     void query(float, float, float, float, std::function<void(Simulation *, Entity &)>);
-};
\ No newline at end of file
+};
+
+#ifdef GENERAL_SPATIAL_HASH
+//entities can cover several cells, so a pair (or a query hit) is only
+//reported from the first cell of the overlap: no per-call dedup set needed
+template <typename Callback>
+void SpatialHash::_collide_columns(uint32_t x0, uint32_t x1, Callback &&on_collide) {
+    for (uint32_t x = x0; x < x1; ++x) {
+        for (uint32_t y = 0; y < MAX_GRID_Y; ++y) {
+            EntityID::id_type const *cell = _cell_begin(x, y);
+            uint32_t const size = _cell_size(x, y);
+            for (uint32_t i = 0; i < size; ++i) {
+                CellRange const &r1 = ranges[cell[i]];
+                for (uint32_t j = i + 1; j < size; ++j) {
+                    CellRange const &r2 = ranges[cell[j]];
+                    if (x != std::max(r1.sx, r2.sx) || y != std::max(r1.sy, r2.sy)) continue;
+                    on_collide(simulation, entities[cell[i]], entities[cell[j]]);
+                }
+            }
+        }
+    }
+}
+
+template <typename Callback>
+void SpatialHash::query(float x, float y, float w, float h, Callback &&cb) {
+    if (dirty) _rebuild();
+    uint32_t sx = fclamp(x - w, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t sy = fclamp(y - h, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    uint32_t ex = fclamp(x + w, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t ey = fclamp(y + h, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    for (uint32_t _x = sx; _x <= ex; ++_x) {
+        for (uint32_t _y = sy; _y <= ey; ++_y) {
+            EntityID::id_type const *cell = _cell_begin(_x, _y);
+            uint32_t const size = _cell_size(_x, _y);
+            for (uint32_t i = 0; i < size; ++i) {
+                CellRange const &r = ranges[cell[i]];
+                if (_x != std::max<uint32_t>(r.sx, sx) || _y != std::max<uint32_t>(r.sy, sy)) continue;
+                Entity &ent = entities[cell[i]];
+                if (ent.get_x() + ent.get_radius() < x - w) continue;
+                if (ent.get_x() - ent.get_radius() > x + w) continue;
+                if (ent.get_y() + ent.get_radius() < y - h) continue;
+                if (ent.get_y() - ent.get_radius() > y + h) continue;
+                cb(simulation, ent);
+            }
+        }
+    }
+}
+#else
+template <typename Callback>
+void SpatialHash::_collide_columns(uint32_t x0, uint32_t x1, Callback &&on_collide) {
+    for (uint32_t x = x0; x < x1; ++x) {
+        for (uint32_t y = 0; y < MAX_GRID_Y; ++y) {
+            EntityID::id_type const *cell = _cell_begin(x, y);
+            uint32_t const size = _cell_size(x, y);
+            for (uint32_t i = 0; i < size; ++i) {
+                Entity &ent = entities[cell[i]];
+                for (uint32_t j = i + 1; j < size; ++j) on_collide(simulation, ent, entities[cell[j]]);
+                if (x < MAX_GRID_X - 1) {
+                    EntityID::id_type const *cell2 = _cell_begin(x+1, y);
+                    for (uint32_t j = 0; j < _cell_size(x+1, y); ++j) on_collide(simulation, ent, entities[cell2[j]]);
+                    if (y > 0) {
+                        EntityID::id_type const *cell2 = _cell_begin(x+1, y-1);
+                        for (uint32_t j = 0; j < _cell_size(x+1, y-1); ++j) on_collide(simulation, ent, entities[cell2[j]]);
+                    }
+                    if (y < MAX_GRID_Y - 1) {
+                        EntityID::id_type const *cell2 = _cell_begin(x+1, y+1);
+                        for (uint32_t j = 0; j < _cell_size(x+1, y+1); ++j) on_collide(simulation, ent, entities[cell2[j]]);
+                    }
+                }
+                if (y < MAX_GRID_Y - 1) {
+                    EntityID::id_type const *cell2 = _cell_begin(x, y+1);
+                    for (uint32_t j = 0; j < _cell_size(x, y+1); ++j) on_collide(simulation, ent, entities[cell2[j]]);
+                }
+            }
+        }
+    }
+}
+
+template <typename Callback>
+void SpatialHash::query(float x, float y, float w, float h, Callback &&cb) {
+    if (dirty) _rebuild();
+    uint32_t sx = fclamp(x - w - GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t sy = fclamp(y - h - GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    uint32_t ex = fclamp(x + w + GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t ey = fclamp(y + h + GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    for (uint32_t _x = sx; _x <= ex; ++_x) {
+        for (uint32_t _y = sy; _y <= ey; ++_y) {
+            EntityID::id_type const *cell = _cell_begin(_x, _y);
+            uint32_t const size = _cell_size(_x, _y);
+            for (uint32_t i = 0; i < size; ++i) {
+                Entity &ent = entities[cell[i]];
+                if (ent.get_x() + ent.get_radius() < x - w) continue;
+                if (ent.get_x() - ent.get_radius() > x + w) continue;
+                if (ent.get_y() + ent.get_radius() < y - h) continue;
+                if (ent.get_y() - ent.get_radius() > y + h) continue;
+                cb(simulation, ent);
+            }
+        }
+    }
+}
+#endif
+
+template <typename Callback>
+void SpatialHash::collide(Callback &&on_collide) {
+    if (dirty) _rebuild();
+    _collide_columns(0, MAX_GRID_X, on_collide);
+}
+
+template <typename Callback>
+void SpatialHash::collide_strips(Callback &&on_collide) {
+    if (dirty) _rebuild();
+    _run_strips([&](uint32_t strip) {
+        _collide_columns(strip * STRIP_WIDTH, std::min(MAX_GRID_X, (strip + 1) * STRIP_WIDTH),
+            [&](Simulation *sim, Entity &ent1, Entity &ent2) { on_collide(sim, ent1, ent2, strip); });
+    });
+}
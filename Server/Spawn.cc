@@ -17,7 +17,7 @@ Entity &alloc_drop(Simulation *sim, PetalID::T drop_id) {
     drop.add_component(kPhysics);
     drop.set_radius(25);
     drop.set_angle(frand() * 0.2 - 0.1);
-    drop.friction = 0.25;
+    drop.friction() = 0.25;
 
     drop.add_component(kRelations);
     drop.set_team(NULL_ENTITY);
@@ -40,12 +40,12 @@ static Entity &__alloc_mob(Simulation *sim, MobID::T mob_id, float x, float y, E
     mob.set_angle(frand() * 2 * M_PI);
     mob.set_x(x);
     mob.set_y(y);
-    mob.friction = DEFAULT_FRICTION;
-    mob.mass = (1 + mob.get_radius() / BASE_FLOWER_RADIUS) * (data.attributes.stationary ? 10000 : 1);
+    mob.friction() = DEFAULT_FRICTION;
+    mob.mass() = (1 + mob.get_radius() / BASE_FLOWER_RADIUS) * (data.attributes.stationary ? 10000 : 1);
     if (mob_id == MobID::kAntHole)
-        BitMath::set(mob.flags, EntityFlags::kNoFriendlyCollision);
+        BitMath::set(mob.flags(), EntityFlags::kNoFriendlyCollision);
     if (team == NULL_ENTITY)
-        BitMath::set(mob.flags, EntityFlags::kHasCulling);
+        BitMath::set(mob.flags(), EntityFlags::kHasCulling);
         
     mob.add_component(kRelations);
     mob.set_team(team);
@@ -113,8 +113,8 @@ Entity &alloc_player(Simulation *sim, EntityID const team) {
 
     player.add_component(kPhysics);
     player.set_radius(BASE_FLOWER_RADIUS);
-    player.friction = DEFAULT_FRICTION;
-    player.mass = 1;
+    player.friction() = DEFAULT_FRICTION;
+    player.mass() = 1;
 
     player.add_component(kFlower);
 
@@ -146,8 +146,8 @@ Entity &alloc_petal(Simulation *sim, PetalID::T petal_id, Entity const &parent)
     petal.set_radius(petal_data.radius + petal_data.attributes.extra_petal_radius);
     if (petal_data.attributes.rotation_style == PetalAttributes::kPassiveRot)
         petal.set_angle(frand() * 2 * M_PI);
-    petal.mass = petal_data.attributes.mass;
-    petal.friction = DEFAULT_FRICTION * 1.5;
+    petal.mass() = petal_data.attributes.mass;
+    petal.friction() = DEFAULT_FRICTION * 1.5;
     petal.add_component(kRelations);
     petal.set_parent(parent.id);
     petal.set_team(parent.get_team());
@@ -175,8 +175,8 @@ Entity &alloc_web(Simulation *sim, float radius, Entity const &parent) {
     web.set_y(parent.get_y());
     web.set_angle(frand() * 2 * M_PI);
     web.set_radius(radius);
-    web.mass = 1.0;
-    web.friction = 1.0;
+    web.mass() = 1.0;
+    web.friction() = 1.0;
     web.add_component(kRelations);
     web.set_team(parent.get_team());
     web.set_parent(parent.id);
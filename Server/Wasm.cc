@@ -12,6 +12,7 @@
 
 #include <emscripten.h>
 #ifdef WASM_SERVER
+#include <Server/Account/AccountLevel.hh>
 #include <Server/Account/WasmAccountStore.hh>
 #endif
 
@@ -114,6 +115,7 @@ extern "C" void wasm_send_petal_gallery_for(const char *account_id_c) {
 extern "C" void wasm_set_account_xp(const char *account_id_c, int xp) {
     if (!account_id_c) return;
     WasmAccountStore::set_xp(std::string(account_id_c), (uint32_t)xp);
+    AccountLevel::on_xp_changed(std::string(account_id_c));
 }
 
 extern "C" void wasm_send_account_level_for(const char *account_id_c) {
@@ -230,6 +230,43 @@ void Reader::Decoder<PersistentFlag>::read(Reader &r, PersistentFlag &ref) {
     ref.set(r.read<uint8_t>());
 }
 
+BitWriter::BitWriter(uint8_t *v) : at(v), acc(0), count(0) {}
+
+void BitWriter::write(uint32_t val, uint32_t bits) {
+    acc |= (uint64_t) (val & (uint32_t) ((1ull << bits) - 1)) << count;
+    count += bits;
+    while (count >= 8) {
+        *at++ = acc;
+        acc >>= 8;
+        count -= 8;
+    }
+}
+
+uint8_t *BitWriter::flush() {
+    if (count > 0) *at++ = acc;
+    acc = 0;
+    count = 0;
+    return at;
+}
+
+BitReader::BitReader(uint8_t const *v) : at(v), acc(0), count(0) {}
+
+uint32_t BitReader::read(uint32_t bits) {
+    //only pulls in bytes as they are needed, so end() lands where the writer flushed
+    while (count < bits) {
+        acc |= (uint64_t) *at++ << count;
+        count += 8;
+    }
+    uint32_t ret = acc & ((1ull << bits) - 1);
+    acc >>= bits;
+    count -= bits;
+    return ret;
+}
+
+uint8_t const *BitReader::end() const {
+    return at;
+}
+
 Validator::Validator(uint8_t const *start, uint8_t const *end) : at(start), end(end) {}
 
 uint8_t Validator::validate_uint8() {
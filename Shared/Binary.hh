@@ -2,6 +2,7 @@
 
 #include <Shared/EntityDef.hh>
 
+#include <cmath>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -20,7 +21,8 @@ enum Clientbound {
     kEntityAccountLevels, // mapping of EntityID -> account level for visible players
     kTopAccountLeader, // entity id of the current top account-level player (player entity id)
 
-    kPingReply // echo reply for RTT measurement
+    kPingReply, // echo reply for RTT measurement
+    kBatch // a tick's worth of the above, each prefixed with its length
 };
 
 
@@ -114,6 +116,65 @@ public:
     uint8_t next();
 };
 
+//fixed-point wire encoding of a float field, see PER_QUANTIZED_FIELD
+struct Quantization {
+    float min;
+    float max;
+    uint8_t bits;
+    //width of a delta against the previous encoded value, 0 to always send it whole
+    uint8_t delta_bits;
+    //values wrap around the range instead of being clamped to it
+    uint8_t wrap;
+    uint32_t encode(float v) const {
+        float const t = (v - min) / (max - min);
+        uint32_t const steps = 1u << bits;
+        if (wrap) return (uint32_t) roundf((t - floorf(t)) * steps) & (steps - 1);
+        if (!(t > 0)) return 0;
+        if (t >= 1) return steps - 1;
+        return roundf(t * (steps - 1));
+    }
+    float decode(uint32_t q) const {
+        if (wrap) return min + (max - min) * ((float) q / (1u << bits));
+        return min + (max - min) * ((float) q / ((1u << bits) - 1));
+    }
+    //shortest signed step from one encoded value to another, modulo 1 << bits
+    int32_t delta(uint32_t from, uint32_t to) const {
+        int32_t d = (to - from) & ((1u << bits) - 1);
+        return d >= (1 << (bits - 1)) ? d - (1 << bits) : d;
+    }
+    uint8_t fits_delta(int32_t d) const {
+        return d >= -(1 << (delta_bits - 1)) && d < (1 << (delta_bits - 1));
+    }
+    uint32_t apply_delta(uint32_t from, uint32_t raw) const {
+        //sign-extend the delta_bits wide two's complement value
+        int32_t d = (int32_t) (raw << (32 - delta_bits)) >> (32 - delta_bits);
+        return (from + d) & ((1u << bits) - 1);
+    }
+};
+
+//packs values of arbitrary bit width, lowest bit first; the stream is padded to a whole byte on flush
+class BitWriter {
+    uint8_t *at;
+    uint64_t acc;
+    uint32_t count;
+public:
+    BitWriter(uint8_t *);
+    void write(uint32_t, uint32_t);
+    //returns the first byte after the stream
+    uint8_t *flush();
+};
+
+class BitReader {
+    uint8_t const *at;
+    uint64_t acc;
+    uint32_t count;
+public:
+    BitReader(uint8_t const *);
+    uint32_t read(uint32_t);
+    //first byte after the stream, as returned by BitWriter::flush
+    uint8_t const *end() const;
+};
+
 class Validator {
 public:
     uint8_t const *at;
@@ -5,7 +5,25 @@
 
 #include <Shared/Binary.hh>
 
-Entity::Entity() {
+constexpr Quantization Entity::quantization(uint32_t field) {
+    #define QUANTIZED(name, min, max, bits, delta_bits, wrap) \
+        if (field == k##name) return { min, max, bits, delta_bits, wrap };
+    PER_QUANTIZED_FIELD
+    #undef QUANTIZED
+    return { 0, 0, 0, 0, 0 };
+}
+
+constexpr uint32_t Entity::base_slot(uint32_t field) {
+    uint32_t slot = 0;
+    #define QUANTIZED(name, min, max, bits, delta_bits, wrap) \
+        if (field == k##name) return slot; \
+        ++slot;
+    PER_QUANTIZED_FIELD
+    #undef QUANTIZED
+    return 0;
+}
+
+Entity::Entity() SERVER_ONLY(: hot(nullptr), slot(0)) {
     init();
 }
 
@@ -13,9 +31,11 @@ void Entity::init() {
     components = 0;
     pending_delete = 0;
     lifetime = 0;
+    for (uint32_t &base : quantized_base) base = 0;
     #define SINGLE(component, name, type) name = {};
     #define MULTIPLE(component, name, type, amt) for (uint32_t n = 0; n < amt; ++n) { name[n] = {}; }
-    PERFIELD
+    SERVER_ONLY(PERFIELD_COLD)
+    CLIENT_ONLY(PERFIELD)
     #undef SINGLE
     #undef MULTIPLE
     #define SINGLE(name, type, reset) name reset;
@@ -23,6 +43,20 @@ void Entity::init() {
     PER_EXTRA_FIELD
     #undef SINGLE
     #undef MULTIPLE
+    #ifdef SERVERSIDE
+    //not bound to a simulation slot yet
+    if (hot == nullptr) return reset_protocol();
+    #define SINGLE(component, name, type) hot->name[slot] = {};
+    #define MULTIPLE(component, name, type, amt) for (uint32_t n = 0; n < amt; ++n) { hot->name[slot][n] = {}; }
+    FIELDS_Physics
+    #undef SINGLE
+    #undef MULTIPLE
+    #define SINGLE(name, type, reset) hot->name[slot] reset;
+    #define MULTIPLE(name, type, amt, reset) for (uint32_t i = 0; i < amt; ++i) { hot->name[slot][i] reset; }
+    PER_HOT_FIELD
+    #undef SINGLE
+    #undef MULTIPLE
+    #endif
     reset_protocol();
 }
 
@@ -54,17 +88,56 @@ type const &Entity::get_##name(uint32_t i) const { \
     DEBUG_ONLY(assert(has_component(k##component));) \
     return name[i]; \
 }
-PERFIELD
+SERVER_ONLY(PERFIELD_COLD)
+CLIENT_ONLY(PERFIELD)
 #undef SINGLE
 #undef MULTIPLE
 
 #ifdef SERVERSIDE
+//only floats are quantized; the overload keeps the field macros type-agnostic
+template<typename T>
+static uint32_t _quantize(Quantization const &, T const &) { return 0; }
+
+static uint32_t _quantize(Quantization const &q, float v) { return q.encode(v); }
+
+//as a delta from what the client holds when there is one and it fits, else whole
+static void _write_quantized(BitWriter &bits, Quantization const &q, uint32_t v, uint32_t const *base) {
+    if (q.delta_bits) {
+        int32_t const d = base ? q.delta(*base, v) : 0;
+        uint8_t const use_delta = base && q.fits_delta(d);
+        bits.write(use_delta, 1);
+        if (use_delta) return bits.write(d, q.delta_bits);
+    }
+    bits.write(v, q.bits);
+}
+
+#define SINGLE(component, name, type) \
+type const &Entity::get_##name() const { \
+    DEBUG_ONLY(assert(has_component(k##component));) \
+    return hot->name[slot]; \
+}
+#define MULTIPLE(component, name, type, amt) \
+type const &Entity::get_##name(uint32_t i) const { \
+    DEBUG_ONLY(assert(has_component(k##component));) \
+    return hot->name[slot][i]; \
+}
+FIELDS_Physics
+#undef SINGLE
+#undef MULTIPLE
+
+//a quantized field only counts as changed once its encoded value moves,
+//and the first move in a tick keeps the value clients hold as the delta baseline
 #define SINGLE(component, name, type) \
 void Entity::set_##name(type const &v) { \
     DEBUG_ONLY(assert(has_component(k##component));) \
     if (name == v) return; \
+    constexpr Quantization q = quantization(k##name); \
+    if (!q.bits) BitMath::set_arr(state, k##name); \
+    else if (_quantize(q, name) != _quantize(q, v)) { \
+        if (!BitMath::at_arr(state, k##name)) quantized_base[base_slot(k##name)] = _quantize(q, name); \
+        BitMath::set_arr(state, k##name); \
+    } \
     name = v; \
-    BitMath::set_arr(state, k##name); \
 }
 #define MULTIPLE(component, name, type, amt) \
 void Entity::set_##name(uint32_t i, type const &v) { \
@@ -74,63 +147,155 @@ void Entity::set_##name(uint32_t i, type const &v) { \
     BitMath::set_arr(state, k##name); \
     BitMath::set_arr(state_per_##name, i); \
 }
-PERFIELD
+PERFIELD_COLD
 #undef SINGLE
 #undef MULTIPLE
 
-template<>
-void Entity::write<true>(Writer *writer) {
+#define SINGLE(component, name, type) \
+void Entity::set_##name(type const &v) { \
+    DEBUG_ONLY(assert(has_component(k##component));) \
+    if (hot->name[slot] == v) return; \
+    constexpr Quantization q = quantization(k##name); \
+    if (!q.bits) BitMath::set_arr(state, k##name); \
+    else if (_quantize(q, hot->name[slot]) != _quantize(q, v)) { \
+        if (!BitMath::at_arr(state, k##name)) quantized_base[base_slot(k##name)] = _quantize(q, hot->name[slot]); \
+        BitMath::set_arr(state, k##name); \
+    } \
+    hot->name[slot] = v; \
+}
+#define MULTIPLE(component, name, type, amt) \
+void Entity::set_##name(uint32_t i, type const &v) { \
+    DEBUG_ONLY(assert(has_component(k##component));) \
+    if (hot->name[slot][i] == v) return; \
+    hot->name[slot][i] = v; \
+    BitMath::set_arr(state, k##name); \
+    BitMath::set_arr(state_per_##name, i); \
+}
+FIELDS_Physics
+#undef SINGLE
+#undef MULTIPLE
+
+//quantized fields go first as one bitfield, padded to a byte, then the rest through the byte encoders
+void Entity::_write_create(Writer *writer) {
     writer->write<uint32_t>(components);
     writer->write<uint32_t>(lifetime);
-    #define SINGLE(component, name, type) { writer->write<type>(name); }
+    BitWriter bits(writer->at);
+    #define SINGLE(component, name, type) if constexpr (quantization(k##name).bits) { \
+        constexpr Quantization q = quantization(k##name); \
+        bits.write(_quantize(q, get_##name()), q.bits); \
+    }
+    #define MULTIPLE(component, name, type, amt)
+    #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
+    PERCOMPONENT
+    #undef SINGLE
+    #undef MULTIPLE
+    writer->at = bits.flush();
+    #define SINGLE(component, name, type) if constexpr (!quantization(k##name).bits) { writer->write<type>(get_##name()); }
     #define MULTIPLE(component, name, type, amt) { \
         for (uint32_t n = 0; n < amt; ++n) \
-            writer->write<type>(name[n]); \
+            writer->write<type>(get_##name(n)); \
     }
-    #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
     PERCOMPONENT
     #undef SINGLE
     #undef MULTIPLE
     #undef COMPONENT
 }
 
-template<>
-void Entity::write<false>(Writer *writer) {
-    #define SINGLE(component, name, type) \
-        if(BitMath::at_arr(state, k##name)) { \
-            writer->write<uint8_t>(k##name); \
-            writer->write<type>(name); \
+//one bit for whether anything changed, then a bit per field of the entity's components
+//(and per element of a changed array) with quantized values inline, then the other changed values
+void Entity::_write_update(Writer *writer, uint8_t delta, uint8_t const *missed) {
+    uint8_t changes[CHANGE_BYTES];
+    uint8_t any = 0;
+    for (uint32_t n = 0; n < CHANGE_BYTES; ++n) {
+        changes[n] = state[n] | (missed ? missed[n] : 0);
+        any |= changes[n];
     }
+    BitWriter bits(writer->at);
+    bits.write(any != 0, 1);
+    #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
+    if (any) {
+        #define SINGLE(component, name, type) { \
+            constexpr Quantization q = quantization(k##name); \
+            uint8_t const changed = BitMath::at_arr(changes, k##name); \
+            bits.write(changed, 1); \
+            if (q.bits && changed) _write_quantized(bits, q, _quantize(q, get_##name()), \
+                delta ? &quantized_base[base_slot(k##name)] : nullptr); \
+        }
+        #define MULTIPLE(component, name, type, amt) { \
+            uint8_t const changed = BitMath::at_arr(changes, k##name); \
+            uint8_t const whole = missed && BitMath::at_arr(missed, k##name); \
+            bits.write(changed, 1); \
+            if (changed) \
+                for (uint32_t n = 0; n < amt; ++n) bits.write(whole || BitMath::at_arr(state_per_##name, n), 1); \
+        }
+        PERCOMPONENT
+        #undef SINGLE
+        #undef MULTIPLE
+    }
+    writer->at = bits.flush();
+    if (!any) return;
+    #define SINGLE(component, name, type) \
+        if (!quantization(k##name).bits && BitMath::at_arr(changes, k##name)) writer->write<type>(get_##name());
     #define MULTIPLE(component, name, type, amt) \
-        if(BitMath::at_arr(state, k##name)) { \
-            writer->write<uint8_t>(k##name); \
-            for (uint32_t n = 0; n < amt; ++n) { \
-                if (BitMath::at_arr(state_per_##name, n)) { \
-                    writer->write<uint8_t>(n); \
-                    writer->write<type>(name[n]); \
-                } \
-            } \
-            writer->write<uint8_t>(amt); \
+        if (BitMath::at_arr(changes, k##name)) { \
+            uint8_t const whole = missed && BitMath::at_arr(missed, k##name); \
+            for (uint32_t n = 0; n < amt; ++n) \
+                if (whole || BitMath::at_arr(state_per_##name, n)) writer->write<type>(get_##name(n)); \
         }
-    #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
     PERCOMPONENT
     #undef SINGLE
     #undef MULTIPLE
     #undef COMPONENT
-    writer->write<uint8_t>(kFieldCount);
 }
 
-void Entity::write(Writer *writer, uint8_t create) {
-    if (create) write<true>(writer);
-    else write<false>(writer);
+uint8_t Entity::has_changes() const {
+    uint8_t any = 0;
+    for (uint32_t n = 0; n < CHANGE_BYTES; ++n) any |= state[n];
+    return any != 0;
+}
+
+void Entity::merge_changes(uint8_t *mask) const {
+    for (uint32_t n = 0; n < CHANGE_BYTES; ++n) mask[n] |= state[n];
+}
+
+void Entity::write(Writer *writer, uint8_t encoding, uint8_t const *missed) {
+    if (encoding == kEncodeCreate) _write_create(writer);
+    else _write_update(writer, encoding == kEncodeDelta, missed);
 }
 #else
 
+template<typename T>
+static void _dequantize(Quantization const &, uint32_t, T &) {}
+
+static void _dequantize(Quantization const &q, uint32_t v, LerpFloat &ref) { ref.set(q.decode(v)); }
+
+static uint32_t _read_quantized(BitReader &bits, Quantization const &q, uint32_t base) {
+    if (q.delta_bits && bits.read(1)) return q.apply_delta(base, bits.read(q.delta_bits));
+    return bits.read(q.bits);
+}
+
 template<>
 void Entity::read<true>(Reader *reader) {
     components = reader->read<uint32_t>();
     lifetime = reader->read<uint32_t>();
-    #define SINGLE(component, name, type) { reader->read<type>(name); BitMath::set_arr(state, k##name); }
+    BitReader bits(reader->at);
+    #define SINGLE(component, name, type) if constexpr (quantization(k##name).bits) { \
+        constexpr Quantization q = quantization(k##name); \
+        uint32_t &base = quantized_base[base_slot(k##name)]; \
+        base = bits.read(q.bits); \
+        _dequantize(q, base, name); \
+        BitMath::set_arr(state, k##name); \
+    }
+    #define MULTIPLE(component, name, type, amt)
+    #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
+    PERCOMPONENT
+    #undef SINGLE
+    #undef MULTIPLE
+    reader->at = bits.end();
+    #define SINGLE(component, name, type) if constexpr (!quantization(k##name).bits) { \
+        reader->read<type>(name); \
+        BitMath::set_arr(state, k##name); \
+    }
     #define MULTIPLE(component, name, type, amt) { \
         BitMath::set_arr(state, k##name); \
         for (uint32_t n = 0; n < amt; ++n) { \
@@ -138,7 +303,6 @@ void Entity::read<true>(Reader *reader) {
             reader->read<type>(name[n]); \
         } \
     }
-    #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
     PERCOMPONENT
     #undef SINGLE
     #undef MULTIPLE
@@ -148,35 +312,59 @@ void Entity::read<true>(Reader *reader) {
 template<>
 void Entity::read<false>(Reader *reader) {
     ++lifetime;
-    while(1) {
-        switch(reader->read<uint8_t>()) {
-            case kFieldCount: { return; }
-            #define SINGLE(component, name, type) case k##name: { \
-                reader->read<type>(name); \
-                BitMath::set_arr(state, k##name); \
-                break; \
-            }
-            #define MULTIPLE(component, name, type, amt) case k##name: { \
-                BitMath::set_arr(state, k##name); \
-                while (1) { \
-                    uint8_t index = reader->read<uint8_t>(); \
-                    if (index >= amt) break; \
-                    reader->read<type>(name[index]); \
-                    BitMath::set_arr(state_per_##name, index); \
-                } \
-                break; \
-            }
-            PERFIELD
-            #undef SINGLE  
-            #undef MULTIPLE      
-        }
+    BitReader bits(reader->at);
+    if (!bits.read(1)) {
+        reader->at = bits.end();
+        return;
+    }
+    //fields and array elements whose values follow the bitfield
+    uint8_t pending[div_round_up(kFieldCount, 8)] = {};
+    #define SINGLE(component, name, type)
+    #define MULTIPLE(component, name, type, amt) uint8_t pending_##name[div_round_up(amt, 8)] = {};
+    PERFIELD
+    #undef SINGLE
+    #undef MULTIPLE
+    #define SINGLE(component, name, type) if (bits.read(1)) { \
+        constexpr Quantization q = quantization(k##name); \
+        BitMath::set_arr(state, k##name); \
+        if (q.bits) { \
+            uint32_t &base = quantized_base[base_slot(k##name)]; \
+            base = _read_quantized(bits, q, base); \
+            _dequantize(q, base, name); \
+        } else BitMath::set_arr(pending, k##name); \
+    }
+    #define MULTIPLE(component, name, type, amt) if (bits.read(1)) { \
+        BitMath::set_arr(state, k##name); \
+        BitMath::set_arr(pending, k##name); \
+        for (uint32_t n = 0; n < amt; ++n) \
+            if (bits.read(1)) BitMath::set_arr(pending_##name, n); \
     }
+    #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
+    PERCOMPONENT
+    #undef SINGLE
+    #undef MULTIPLE
+    reader->at = bits.end();
+    #define SINGLE(component, name, type) \
+        if (BitMath::at_arr(pending, k##name)) reader->read<type>(name);
+    #define MULTIPLE(component, name, type, amt) \
+        if (BitMath::at_arr(pending, k##name)) { \
+            for (uint32_t n = 0; n < amt; ++n) { \
+                if (!BitMath::at_arr(pending_##name, n)) continue; \
+                reader->read<type>(name[n]); \
+                BitMath::set_arr(state_per_##name, n); \
+            } \
+        }
+    PERCOMPONENT
+    #undef SINGLE
+    #undef MULTIPLE
+    #undef COMPONENT
 }
 
 void Entity::read(Reader *reader, uint8_t create) {
     if (create) read<true>(reader);
     else read<false>(reader);
 }
+#endif
 
 #define SINGLE(component, name, type) \
 uint8_t Entity::get_state_##name() const { \
@@ -192,4 +380,3 @@ uint8_t Entity::get_state_##name(uint32_t i) const { \
 PERFIELD
 #undef SINGLE
 #undef MULTIPLE
-#endif
\ No newline at end of file
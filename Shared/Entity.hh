@@ -13,6 +13,7 @@ typedef CircularArray<PetalID::T, MAX_SLOT_COUNT> circ_arr_t;
 
 SERVER_ONLY(class Writer;)
 CLIENT_ONLY(class Reader;)
+struct Quantization;
 
 SERVER_ONLY(typedef uint8_t StickyFlag;)
 CLIENT_ONLY(typedef PersistentFlag StickyFlag;)
@@ -20,6 +21,34 @@ CLIENT_ONLY(typedef PersistentFlag StickyFlag;)
 SERVER_ONLY(typedef float Float;)
 CLIENT_ONLY(typedef LerpFloat Float;)
 
+#ifdef SERVERSIDE
+//how an entity is written into a client's update
+enum EntityEncoding : uint8_t {
+    //every field, for clients that just started seeing it
+    kEncodeCreate,
+    //changed fields, quantized ones relative to the previous update where they fit
+    kEncodeDelta,
+    //changed fields as absolute values, for clients that missed the previous update
+    kEncodeUpdate,
+    kEncodingCount
+};
+
+//struct of arrays indexed by entity id, so motion and collision
+//can run over these without pulling whole entities into cache
+struct EntityHotFields {
+#define SINGLE(component, name, type) type name[ENTITY_CAP];
+#define MULTIPLE(component, name, type, amt) type name[ENTITY_CAP][amt];
+    FIELDS_Physics
+#undef SINGLE
+#undef MULTIPLE
+#define SINGLE(name, type, reset) type name[ENTITY_CAP];
+#define MULTIPLE(name, type, amt, reset) type name[ENTITY_CAP][amt];
+    PER_HOT_FIELD
+#undef SINGLE
+#undef MULTIPLE
+};
+#endif
+
 enum Components {
     #define COMPONENT(name) k##name,
     PERCOMPONENT
@@ -36,18 +65,40 @@ class Entity {
         #undef MULTIPLE
         kFieldCount
     };
+    //wire encoding from PER_QUANTIZED_FIELD, zero bits for fields that use the byte encoders
+    static constexpr Quantization quantization(uint32_t);
+    static constexpr uint32_t base_slot(uint32_t);
     uint32_t components;
-#define SINGLE(component, name, type) type name;
-#define MULTIPLE(component, name, type, amt) type name[amt];
-    PERFIELD
-#undef SINGLE
-#undef MULTIPLE
+#ifdef SERVERSIDE
+    friend class Simulation;
+    EntityHotFields *hot;
+    EntityID::id_type slot;
+#endif
+public:
+    //kept in front of the fields so per-tick passes stay on one cache line
+    uint32_t lifetime;
+    EntityID id;
+    uint8_t pending_delete;
+private:
     uint8_t state[div_round_up(kFieldCount, 8)];
+    //encoded value of each quantized field as clients hold it, indexed by base_slot: as of the
+    //previous update on the server, as last received on the client; deltas are taken against this
+#define QUANTIZED(name, min, max, bits, delta_bits, wrap) + 1
+    uint32_t quantized_base[0 PER_QUANTIZED_FIELD];
+#undef QUANTIZED
 #define SINGLE(component, name, type);
 #define MULTIPLE(component, name, type, amt) uint8_t state_per_##name[div_round_up(amt, 8)];
     PERFIELD
 #undef SINGLE
 #undef MULTIPLE
+#define SINGLE(component, name, type) type name;
+#define MULTIPLE(component, name, type, amt) type name[amt];
+    SERVER_ONLY(PERFIELD_COLD)
+    CLIENT_ONLY(PERFIELD)
+#undef SINGLE
+#undef MULTIPLE
+    SERVER_ONLY(void _write_create(Writer *);)
+    SERVER_ONLY(void _write_update(Writer *, uint8_t, uint8_t const *);)
 public:
     Entity();
     void init();
@@ -55,9 +106,6 @@ public:
     Entity(Entity const &) = delete;
     Entity &operator=(Entity const &) = delete;
     Entity &operator=(Entity &&) = delete;
-    uint32_t lifetime;
-    EntityID id;
-    uint8_t pending_delete;
     void add_component(uint32_t);
     uint8_t has_component(uint32_t) const;
 
@@ -74,10 +122,23 @@ public:
 #undef MULTIPLE
 
 #ifdef SERVERSIDE
-    void write(Writer *, uint8_t);
+#define SINGLE(name, type, reset) \
+    type &name() { return hot->name[slot]; } \
+    type const &name() const { return hot->name[slot]; }
+#define MULTIPLE(name, type, amt, reset) \
+    type &name(uint32_t i) { return hot->name[slot][i]; } \
+    type const &name(uint32_t i) const { return hot->name[slot][i]; }
+    PER_HOT_FIELD
+#undef SINGLE
+#undef MULTIPLE
 
-    template<bool>
-    void write(Writer *);
+    //one bit per field, for tracking changes a client has not been sent yet
+    static uint32_t const CHANGE_BYTES = div_round_up(kFieldCount, 8);
+    uint8_t has_changes() const;
+    //ors this tick's changed fields into the mask
+    void merge_changes(uint8_t *) const;
+    //encoding is one of EntityEncoding; fields set in the optional mask are also sent, absolute and whole
+    void write(Writer *, uint8_t, uint8_t const * = nullptr);
 #define SINGLE(component, name, type) void set_##name(type const &);
 #define MULTIPLE(component, name, type, amt) void set_##name(uint32_t, type const &);
     PERFIELD
@@ -89,11 +150,12 @@ public:
 
     template<bool>
     void read(Reader *);
+#endif
 
+    //whether the field changed this tick
     #define SINGLE(component, name, type) uint8_t get_state_##name() const;
     #define MULTIPLE(component, name, type, amt) uint8_t get_state_##name(uint32_t) const;
     PERFIELD
     #undef SINGLE
     #undef MULTIPLE
-#endif
 };
\ No newline at end of file
@@ -2,10 +2,13 @@
 
 #include <Shared/StaticDefinitions.hh>
 
+#include <cmath>
 #include <cstdint>
 
 typedef uint16_t game_tick_t;
 
+inline uint32_t const ENTITY_CAP = 8192;
+
 #define PERCOMPONENT \
     COMPONENT(Physics) \
     COMPONENT(Camera) \
@@ -22,6 +25,10 @@ typedef uint16_t game_tick_t;
 
 #define PERFIELD \
 FIELDS_Physics \
+PERFIELD_COLD
+
+//the server stores FIELDS_Physics in EntityHotFields instead of Entity
+#define PERFIELD_COLD \
 FIELDS_Camera \
 FIELDS_Relations \
 FIELDS_Flower \
@@ -86,8 +93,19 @@ SINGLE(Score, score, uint32_t)
 SINGLE(Name, name, std::string) \
 SINGLE(Name, nametag_visible, uint8_t)
 
+//float fields sent as fixed point instead of a varint of v * 64: name, min, max, bits, delta bits, wrap
+//values outside [min, max] are clamped, or wrapped around it if wrap is set
+//with delta bits, a change small enough is sent relative to the value the client already holds
+#define PER_QUANTIZED_FIELD \
+QUANTIZED(x, -1024, ARENA_WIDTH + 1024, 20, 10, 0) \
+QUANTIZED(y, -1024, ARENA_HEIGHT + 1024, 17, 10, 0) \
+QUANTIZED(radius, 0, 1024, 14, 0, 0) \
+QUANTIZED(angle, 0, 2 * M_PI, 12, 7, 1) \
+QUANTIZED(health_ratio, 0, 1, 10, 0, 0)
+
 #ifdef SERVERSIDE
-#define PER_EXTRA_FIELD \
+//read every tick by motion and collision, stored per id in EntityHotFields
+#define PER_HOT_FIELD \
     SINGLE(velocity, Vector, .set(0,0)) \
     SINGLE(collision_velocity, Vector, .set(0,0)) \
     SINGLE(acceleration, Vector, .set(0,0)) \
@@ -95,13 +113,18 @@ SINGLE(Name, nametag_visible, uint8_t)
     SINGLE(mass, float, =1) \
     SINGLE(speed_ratio, float, =1) \
     \
+    SINGLE(slow_ticks, game_tick_t, =0) \
+    SINGLE(projectile_decay_active, uint8_t, =0) \
+    SINGLE(projectile_init_speed, float, =0) \
+    SINGLE(projectile_target_ratio, float, =0) \
+    SINGLE(flags, uint16_t, =0)
+
+#define PER_EXTRA_FIELD \
     MULTIPLE(loadout, LoadoutSlot, MAX_SLOT_COUNT, .reset()) \
     SINGLE(heading_angle, float, =0) \
     SINGLE(player_count, uint32_t, =0) \
-    SINGLE(flags, uint16_t, =0) \
     SINGLE(input, uint8_t, =0) \
     \
-    SINGLE(slow_ticks, game_tick_t, =0) \
     SINGLE(slow_inflict, game_tick_t, =0) \
     SINGLE(immunity_ticks, game_tick_t, =0) \
     SINGLE(dandy_ticks, game_tick_t, =0) \
@@ -121,9 +144,12 @@ SINGLE(Name, nametag_visible, uint8_t)
     SINGLE(damage_reflection, float, =0) \
     SINGLE(last_damaged_by, EntityID, =NULL_ENTITY) \
     SINGLE(score_reward, uint32_t, =0) \
+    SINGLE(account_level, uint32_t, =0) \
     \
     SINGLE(base_entity, EntityID, =NULL_ENTITY) \
     SINGLE(target, EntityID, =NULL_ENTITY) \
+    SINGLE(nearest_enemy, EntityID, =NULL_ENTITY) \
+    SINGLE(nearest_enemy_dist, float, =-1) \
     SINGLE(seg_head, EntityID, =NULL_ENTITY) \
     SINGLE(detection_radius, float, =0) \
     SINGLE(ai_state, uint8_t, =0) \
@@ -131,9 +157,6 @@ SINGLE(Name, nametag_visible, uint8_t)
     SINGLE(zone, uint8_t, =0) \
     SINGLE(deletion_tick, uint8_t, =0) \
     SINGLE(deleted_petals, circ_arr_t, ={}) \
-    SINGLE(projectile_decay_active, uint8_t, =0) \
-    SINGLE(projectile_init_speed, float, =0) \
-        SINGLE(projectile_target_ratio, float, =0) \
     MULTIPLE(damagers, EntityID, 16, =NULL_ENTITY) \
     SINGLE(damager_count, uint8_t, =0)
 #else
@@ -146,7 +169,9 @@ SINGLE(Name, nametag_visible, uint8_t)
     SINGLE(eye_y, float, =0) \
     SINGLE(mouth, float, =15) \
     SINGLE(animation, float, =0) \
-    SINGLE(damage_flash, float, =0)
+    SINGLE(damage_flash, float, =0) \
+    SINGLE(last_update, uint32_t, =0) \
+    SINGLE(update_interval, uint32_t, =1)
 #endif
 
 
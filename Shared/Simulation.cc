@@ -1,5 +1,9 @@
 #include <Shared/Simulation.hh>
 
+#ifdef SERVERSIDE
+#include <Server/Account/AccountLink.hh>
+#endif
+
 #ifdef DEBUG
 #include <iostream>
 
@@ -9,13 +13,27 @@ std::ostream &operator<<(std::ostream &out, EntityID const &id) {
 #endif
 
 Simulation::Simulation() SERVER_ONLY(: spatial_hash(this)) {
+    #ifdef SERVERSIDE
+    for (EntityID::id_type i = 0; i < ENTITY_CAP; ++i) {
+        entities[i].hot = &hot_fields;
+        entities[i].slot = i;
+    }
+    #endif
     reset();
 }
 
 void Simulation::reset() {
+    alive_entities.clear();
     active_entities.clear();
+    for (auto &list : component_entities) list.clear();
     hash_tracker = {0};
     entity_tracker = {0};
+    free_ids.fill(~0ull);
+    free_id_words = {0};
+    for (uint32_t i = 0; i < free_ids.size(); ++i)
+        BitMath::set(free_id_words[i / 64], i % 64);
+    //id 0 is the null entity
+    BitMath::unset(free_ids[0], 0);
     
     for (EntityID::id_type i = 0; i < ENTITY_CAP; ++i)
         entities[i].init();
@@ -23,15 +41,38 @@ void Simulation::reset() {
     arena_info.init();
     #ifdef SERVERSIDE
     spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
+    leaderboard.clear();
     petal_count_tracker = {0};
     zone_mob_counts = {0};
     #endif
 }
 
+void Simulation::_mark_used(EntityID::id_type i) {
+    BitMath::unset(free_ids[i / 64], i % 64);
+    if (free_ids[i / 64] == 0) BitMath::unset(free_id_words[i / 4096], (i / 64) % 64);
+    alive_index[i] = alive_entities.size();
+    alive_entities.push(i);
+}
+
+void Simulation::_mark_free(EntityID::id_type i) {
+    BitMath::set(free_ids[i / 64], i % 64);
+    BitMath::set(free_id_words[i / 4096], (i / 64) % 64);
+    //swap-remove, order of alive_entities is not meaningful
+    EntityID::id_type last = alive_entities.pop();
+    if (last == i) return;
+    alive_entities[alive_index[i]] = last;
+    alive_index[last] = alive_index[i];
+}
+
 Entity &Simulation::alloc_ent() {
-    for (EntityID::id_type i = 1; i < ENTITY_CAP; ++i) {
-        if (BitMath::at_arr(entity_tracker.data(), i)) continue;
+    //always hands out the lowest free id
+    for (uint32_t w = 0; w < free_id_words.size(); ++w) {
+        if (free_id_words[w] == 0) continue;
+        uint32_t word = w * 64 + BitMath::lowest(free_id_words[w]);
+        EntityID::id_type i = word * 64 + BitMath::lowest(free_ids[word]);
+        DEBUG_ONLY(assert(!BitMath::at_arr(entity_tracker.data(), i));)
         BitMath::set_arr(entity_tracker.data(), i);
+        _mark_used(i);
         entities[i].init();
         DEBUG_ONLY(std::cout << "ent_create " << EntityID(i, hash_tracker[i]) << "\n";)
         entities[i].id = EntityID(i, hash_tracker[i]);
@@ -51,6 +92,7 @@ void Simulation::force_alloc_ent(EntityID const &id) {
     assert(!BitMath::at_arr(entity_tracker.data(), id.id));
     entities[id.id].init();
     BitMath::set_arr(entity_tracker.data(), id.id);
+    _mark_used(id.id);
     hash_tracker[id.id] = id.hash;
     entities[id.id].id = id;
 }
@@ -74,35 +116,25 @@ void Simulation::_delete_ent(EntityID const &id) {
     DEBUG_ONLY(std::cout << "ent_delete " << id << "\n";)
     DEBUG_ONLY(assert(ent_exists(id)));
     BitMath::unset_arr(entity_tracker.data(), id.id);
+    SERVER_ONLY(spatial_hash.remove(id);)
+    SERVER_ONLY(leaderboard.remove(id);)
+    SERVER_ONLY(AccountLink::unmap(id);)
+    _mark_free(id.id);
     hash_tracker[id.id]++;
 }
 
 void Simulation::tick() {
     active_entities.clear();
-    for (EntityID::id_type i = 1; i < ENTITY_CAP; ++i) {
-        if (!BitMath::at_arr(entity_tracker.data(), i)) continue;
-        active_entities.push(entities[i].id.id);
+    for (auto &list : component_entities) list.clear();
+    for (EntityID::id_type i : alive_entities) {
+        active_entities.push(i);
+        Entity const &ent = entities[i];
+        for (uint32_t comp = 0; comp < kComponentCount; ++comp)
+            if (ent.has_component(comp)) component_entities[comp].push(i);
     }
     on_tick();
 }
 
-void Simulation::for_each_entity(std::function<void(Simulation *, Entity &)> cb) { \
-    for (EntityID::id_type i = 0; i < active_entities.size(); ++i) { \
-        if (!BitMath::at_arr(entity_tracker.data(), active_entities[i])) continue; \
-        Entity &ent = entities[active_entities[i]]; \
-        cb(this, ent); \
-    } \
-}
-
-#define COMPONENT(name) \
-template<> \
-void Simulation::for_each<k##name>(std::function<void(Simulation *, Entity &)> cb) { \
-    for (EntityID::id_type i = 0; i < active_entities.size(); ++i) { \
-        if (!BitMath::at_arr(entity_tracker.data(), active_entities[i])) continue; \
-        Entity &ent = entities[active_entities[i]]; \
-        SERVER_ONLY(if (ent.pending_delete) continue;) \
-        if (ent.has_component(k##name)) cb(this, ent); \
-    } \
-}
-PERCOMPONENT
-#undef COMPONENT
\ No newline at end of file
+void Simulation::for_each_entity(std::function<void(Simulation *, Entity &)> cb) {
+    for_each_entity<std::function<void(Simulation *, Entity &)> &>(cb);
+}
\ No newline at end of file
@@ -4,23 +4,41 @@
 #include <Shared/Entity.hh>
 
 #ifdef SERVERSIDE
+#include <Server/DeltaCache.hh>
+#include <Server/Leaderboard.hh>
 #include <Server/SpatialHash.hh>
 #endif
 
 #include <functional>
 #include <string>
 
-inline uint32_t const ENTITY_CAP = 8192;
+static_assert(ENTITY_CAP % 64 == 0);
 
 class Simulation {
     std::array<uint8_t, div_round_up(ENTITY_CAP, 8)> entity_tracker;
+    //set bits are free ids, second level marks words with any free bit
+    std::array<uint64_t, div_round_up(ENTITY_CAP, 64)> free_ids;
+    std::array<uint64_t, div_round_up(ENTITY_CAP, 64 * 64)> free_id_words;
     std::array<EntityID::hash_type, ENTITY_CAP> hash_tracker;
     std::array<Entity, ENTITY_CAP> entities;
+    //packed list of allocated ids, kept up to date by alloc/delete
+    StaticArray<EntityID::id_type, ENTITY_CAP> alive_entities;
+    std::array<EntityID::id_type, ENTITY_CAP> alive_index;
+    //copy of alive_entities taken at the start of tick()
     StaticArray<EntityID::id_type, ENTITY_CAP> active_entities;
+    //active_entities split by component, filled in the same pass
+    std::array<StaticArray<EntityID::id_type, ENTITY_CAP>, kComponentCount> component_entities;
+    void _mark_used(EntityID::id_type);
+    void _mark_free(EntityID::id_type);
+    SERVER_ONLY(friend class SpatialHash;)
+    SERVER_ONLY(void _run_chunks(uint32_t, std::function<void(uint32_t)> const &);)
 public:
     SERVER_ONLY(std::array<uint32_t, PetalID::kNumPetals> petal_count_tracker;)
     SERVER_ONLY(std::array<uint32_t, MAP_DATA.size()> zone_mob_counts;)
     SERVER_ONLY(SpatialHash spatial_hash;)
+    SERVER_ONLY(EntityHotFields hot_fields;)
+    SERVER_ONLY(DeltaCache delta_cache;)
+    SERVER_ONLY(Leaderboard leaderboard;)
     Arena arena_info;
     Simulation();
     void reset();
@@ -36,7 +54,58 @@ public:
     void post_tick();
 
     //will only consider active entities from the start of the tick() call
+    template <typename Callback>
+    void for_each_entity(Callback &&);
+    template <uint8_t, typename Callback>
+    void for_each(Callback &&);
     void for_each_entity(std::function<void (Simulation *, Entity &)>);
-    template <uint8_t>
-    void for_each(std::function<void (Simulation *, Entity &)>);
-};
\ No newline at end of file
+    template <uint8_t component>
+    void for_each(std::function<void (Simulation *, Entity &)> cb) {
+        for_each<component, std::function<void (Simulation *, Entity &)> &>(cb);
+    }
+    //for_each split into fixed runs of entities that are visited on the job system
+    //cb also gets the run index for per-run output; runs are the same for any thread count
+    SERVER_ONLY(template <uint8_t component> uint32_t chunk_count(uint32_t) const;)
+    SERVER_ONLY(template <uint8_t component, typename Callback> void for_each_chunk(uint32_t, Callback &&);)
+};
+
+template <typename Callback>
+void Simulation::for_each_entity(Callback &&cb) {
+    for (EntityID::id_type i = 0; i < active_entities.size(); ++i) {
+        if (!BitMath::at_arr(entity_tracker.data(), active_entities[i])) continue;
+        Entity &ent = entities[active_entities[i]];
+        cb(this, ent);
+    }
+}
+
+template <uint8_t component, typename Callback>
+void Simulation::for_each(Callback &&cb) {
+    StaticArray<EntityID::id_type, ENTITY_CAP> const &list = component_entities[component];
+    for (EntityID::id_type i = 0; i < list.size(); ++i) {
+        if (!BitMath::at_arr(entity_tracker.data(), list[i])) continue;
+        Entity &ent = entities[list[i]];
+        SERVER_ONLY(if (ent.pending_delete) continue;)
+        if (ent.has_component(component)) cb(this, ent);
+    }
+}
+
+#ifdef SERVERSIDE
+template <uint8_t component>
+uint32_t Simulation::chunk_count(uint32_t chunk) const {
+    return div_round_up(component_entities[component].size(), chunk);
+}
+
+template <uint8_t component, typename Callback>
+void Simulation::for_each_chunk(uint32_t chunk, Callback &&cb) {
+    StaticArray<EntityID::id_type, ENTITY_CAP> const &list = component_entities[component];
+    _run_chunks(chunk_count<component>(chunk), [&](uint32_t c) {
+        uint32_t const end = std::min<uint32_t>(list.size(), (c + 1) * chunk);
+        for (uint32_t i = c * chunk; i < end; ++i) {
+            if (!BitMath::at_arr(entity_tracker.data(), list[i])) continue;
+            Entity &ent = entities[list[i]];
+            if (ent.pending_delete) continue;
+            if (ent.has_component(component)) cb(this, ent, c);
+        }
+    });
+}
+#endif
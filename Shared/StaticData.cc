@@ -1,5 +1,6 @@
 #include <Shared/StaticData.hh>
 
+#include <algorithm>
 #include <cmath>
 
 uint32_t const MAX_LEVEL = 99;
@@ -1346,6 +1347,28 @@ uint32_t score_to_pass_level(uint32_t level) {
     return (uint32_t)(pow(1.06, level - 1) * level) + 3;
 }
 
+//same curve as score_to_pass_level; repeated multiplication gives the same whole numbers as pow
+//for every level, and it can run at compile time
+static constexpr std::array<uint32_t, MAX_LEVEL + 2> _account_level_xp() {
+    std::array<uint32_t, MAX_LEVEL + 2> table{};
+    double growth = 1;
+    for (uint32_t level = 1; level <= MAX_LEVEL; ++level) {
+        table[level + 1] = table[level] + ((uint32_t)(growth * level) + 3) * ACCOUNT_XP_MULTIPLIER;
+        growth *= 1.06;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, MAX_LEVEL + 2> ACCOUNT_LEVEL_XP_TABLE = _account_level_xp();
+static_assert(ACCOUNT_LEVEL_XP_TABLE[2] == 4 * ACCOUNT_XP_MULTIPLIER);
+uint32_t const *const ACCOUNT_LEVEL_XP = ACCOUNT_LEVEL_XP_TABLE.data();
+
+uint32_t account_xp_to_level(uint32_t xp) {
+    //first level past the one this xp reaches, searched among 1..MAX_LEVEL
+    auto it = std::upper_bound(ACCOUNT_LEVEL_XP_TABLE.begin() + 1, ACCOUNT_LEVEL_XP_TABLE.begin() + MAX_LEVEL + 1, xp);
+    return it - ACCOUNT_LEVEL_XP_TABLE.begin() - 1;
+}
+
 uint32_t score_to_level(uint32_t score) {
     uint32_t level = 1;
     while (level < MAX_LEVEL) {
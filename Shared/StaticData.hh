@@ -160,6 +160,9 @@ std::array const ANTHOLE_SPAWNS = std::to_array<StaticArray<MobID::T, 3>>({
 extern uint32_t score_to_pass_level(uint32_t);
 extern uint32_t score_to_level(uint32_t);
 extern uint32_t level_to_score(uint32_t);
+//total account xp needed to reach each level, up to one past MAX_LEVEL
+extern uint32_t const *const ACCOUNT_LEVEL_XP;
+extern uint32_t account_xp_to_level(uint32_t);
 extern uint32_t loadout_slots_at_level(uint32_t);
 
 extern float hp_at_level(uint32_t);
\ No newline at end of file